@@ -515,7 +515,7 @@ Ax88179Reset (
 
   if (EFI_ERROR(Status)) goto err;
 
-  Val = 12; //AX88179_BULKIN_SIZE_INK - 1;
+  Val = AX88179_BULKIN_SIZE_INK - 2;
   Status =  Ax88179MacWrite (RXBINQSIZE,
                               0x01,
                               NicDevice,
@@ -1028,6 +1028,8 @@ done:
       NicDevice->PktCnt = TmpPktCnt;
       NicDevice->CurPktHdrOff = NicDevice->BulkInbuf + tmplen;
       NicDevice->CurPktOff = NicDevice->BulkInbuf;
+      NicDevice->RxDataEnd = NicDevice->BulkInbuf + tmplen;
+      NicDevice->RxHdrEnd = NicDevice->BulkInbuf + LengthInBytes - 4;
       *((UINT16 *) (NicDevice->BulkInbuf + LengthInBytes - 4)) = 0;
       *((UINT16*) (NicDevice->BulkInbuf + LengthInBytes - 2)) = 0;
       Status = EFI_SUCCESS;
@@ -69,7 +69,12 @@
 #define USB_NETWORK_CLASS   0x09    ///<  USB Network class code
 #define USB_BUS_TIMEOUT     1000    ///<  USB timeout in milliseconds
 
-#define AX88179_BULKIN_SIZE_INK     2
+//
+//  Receive buffer size in KB.  The device aggregates up to
+//  (AX88179_BULKIN_SIZE_INK - 2) KB of frames into a single bulk-in burst,
+//  so a single UsbBulkTransfer drains dozens of frames at gigabit rates.
+//
+#define AX88179_BULKIN_SIZE_INK     24
 #define AX88179_MAX_BULKIN_SIZE    (1024 * AX88179_BULKIN_SIZE_INK)
 #define AX88179_MAX_PKT_SIZE  2048
 
@@ -278,6 +283,8 @@ typedef struct {
   UINT16                    PktCnt;
   UINT8                     *CurPktHdrOff;
   UINT8                     *CurPktOff;
+  UINT8                     *RxDataEnd;
+  UINT8                     *RxHdrEnd;
 
   TX_PACKET                 *TxTest;
 
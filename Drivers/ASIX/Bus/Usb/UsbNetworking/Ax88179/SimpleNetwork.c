@@ -528,7 +528,9 @@ SN_Receive (
   EFI_STATUS              Status;
   UINT16                  Type = 0;
   UINT16                  CurrentPktLen;
-  BOOLEAN                 Valid = TRUE;
+  UINT16                  PktHdrLen;
+  UINTN                   PktStride;
+  BOOLEAN                 Valid;
   EFI_TPL                 TplPrevious;
 
   TplPrevious = gBS->RaiseTPL (TPL_CALLBACK);
@@ -570,15 +572,46 @@ SN_Receive (
           if (EFI_ERROR(Status))
             goto  no_pkt;
         }
-        CurrentPktLen = *((UINT16*) (NicDevice->CurPktHdrOff + 2));
-        if (CurrentPktLen & (RXHDR_DROP | RXHDR_CRCERR))
-          Valid = FALSE;
-        CurrentPktLen &=  0x1fff;
-        CurrentPktLen -= 2; /*EEEE*/
-
-        if (Valid && (60 <= CurrentPktLen) &&
-        ((CurrentPktLen - 14) <= MAX_ETHERNET_PKT_SIZE) &&
-            (*((UINT16*)NicDevice->CurPktOff)) == 0xEEEE) {
+
+        //
+        //  Skip the frames the device flagged as bad, rather than dropping
+        //  the rest of the aggregated burst along with them
+        //
+        while (NicDevice->PktCnt != 0) {
+          if ((NicDevice->CurPktHdrOff + 4) > NicDevice->RxHdrEnd) {
+            //
+            //  Ran into the trailer, drop the burst
+            //
+            NicDevice->PktCnt = 0;
+            break;
+          }
+
+          PktHdrLen = *((UINT16*) (NicDevice->CurPktHdrOff + 2));
+          Valid = (PktHdrLen & (RXHDR_DROP | RXHDR_CRCERR)) == 0;
+          PktStride = ((PktHdrLen & 0x1fff) + 7) & 0xfff8;
+
+          if ((PktStride == 0) ||
+              (*((UINT16*)NicDevice->CurPktOff)) != 0xEEEE ||
+              (NicDevice->CurPktOff + PktStride) > NicDevice->RxDataEnd) {
+            //
+            //  Lost track of the frame boundaries, drop the burst
+            //
+            NicDevice->PktCnt = 0;
+            break;
+          }
+
+          CurrentPktLen = (PktHdrLen & 0x1fff) - 2; /*EEEE*/
+          if (Valid && (60 <= CurrentPktLen) &&
+              ((CurrentPktLen - 14) <= MAX_ETHERNET_PKT_SIZE)) {
+            break;
+          }
+
+          NicDevice->PktCnt--;
+          NicDevice->CurPktHdrOff += 4;
+          NicDevice->CurPktOff += PktStride;
+        }
+
+        if (NicDevice->PktCnt != 0) {
           if (*BufferSize < (UINTN)CurrentPktLen) {
             gBS->RestoreTPL (TplPrevious);
             return EFI_BUFFER_TOO_SMALL;
@@ -605,10 +638,9 @@ SN_Receive (
           }
           NicDevice->PktCnt--;
           NicDevice->CurPktHdrOff += 4;
-          NicDevice->CurPktOff += (CurrentPktLen + 2 + 7) & 0xfff8;
+          NicDevice->CurPktOff += PktStride;
           Status = EFI_SUCCESS;
         } else {
-          NicDevice->PktCnt = 0;
           Status = EFI_NOT_READY;
         }
       } else {
@@ -69,6 +69,27 @@ CheckBounds (
   return EFI_SUCCESS;
 }
 
+/**
+ * Extend the area of the screen that is "dirty" - that we need to look at in the next screen update.
+ * @param UsbDisplayLinkDev
+ * @param Y
+ * @param Height
+ */
+STATIC VOID
+MarkDirtyLines (
+  IN  USB_DISPLAYLINK_DEV                     *UsbDisplayLinkDev,
+  IN  UINTN                                   Y,
+  IN  UINTN                                   Height
+)
+{
+  if (Y < UsbDisplayLinkDev->LastY1) {
+    UsbDisplayLinkDev->LastY1 = Y;
+  }
+  if ((Y + Height) > UsbDisplayLinkDev->LastY2) {
+    UsbDisplayLinkDev->LastY2 = Y + Height;
+  }
+}
+
 /**
  * Update the local copy of the Frame Buffer. This local copy is periodically transmitted to the
  * DisplayLink device (via DlGopSendScreenUpdate)
@@ -121,13 +142,7 @@ BuildBackBuffer (
 
   case EfiBltBufferToVideo:
   {
-    // Update the store of the area of the screen that is "dirty" - that we need to send in the next screen update.
-    if (DestinationY < UsbDisplayLinkDev->LastY1) {
-      UsbDisplayLinkDev->LastY1 = DestinationY;
-    }
-    if ((DestinationY + Height) > UsbDisplayLinkDev->LastY2) {
-      UsbDisplayLinkDev->LastY2 = DestinationY + Height;
-    }
+    MarkDirtyLines (UsbDisplayLinkDev, DestinationY, Height);
 
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
@@ -146,6 +161,8 @@ BuildBackBuffer (
 
   case EfiBltVideoToVideo:
   {
+    MarkDirtyLines (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcB;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     SrcB = UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX;
@@ -163,6 +180,8 @@ BuildBackBuffer (
 
   case EfiBltVideoFill:
   {
+    MarkDirtyLines (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
     for (H = 0; H < Height; H++) {
@@ -252,7 +271,12 @@ DlGopSendTestPattern (
 
 
 /**
- * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device
+ * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device.
+ *
+ * The dirty lines of the back buffer (Screen) are converted into the front buffer (SentScreen)
+ * at TPL_NOTIFY, comparing them with what the device is already showing as we go. If nothing
+ * actually changed, no frame is sent at all. Otherwise the frame is sent from the front buffer,
+ * without holding off Blt - only this function (run from the one-shot timer) writes SentScreen.
  * @param UsbDisplayLinkDev
  * @return
  */
@@ -263,83 +287,122 @@ DlGopSendScreenUpdate (
 {
   EFI_STATUS Status;
   UINT32 USBStatus;
+  EFI_TPL OriginalTPL;
+  UINTN DataLen;
+  UINTN Width;
+  UINTN Height;
+  UINTN FirstY;
+  UINTN LastY;
+  UINTN LinesChanged;
+  UINTN BytesSent;
+  UINTN H;
+  UINTN W;
+  BOOLEAN LineChanged;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcPtr;
+  UINT8* LinePtr;
+  UINT8* DstPtr;
+
   Status = EFI_SUCCESS;
+  DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
+  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
+  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
 
   // If it has been a while since we sent an update, send a full screen.
   // This allows us to update a hot-plugged monitor quickly.
   if (UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD) {
-    UsbDisplayLinkDev->LastY1 = 0;
-    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution - 1;
+    UsbDisplayLinkDev->FullScreenUpdate = TRUE;
   }
 
   // If there has been no BLT since the last update/poll, drop out quietly.
-  if (UsbDisplayLinkDev->LastY2 < UsbDisplayLinkDev->LastY1) {
+  if (!UsbDisplayLinkDev->FullScreenUpdate && (UsbDisplayLinkDev->LastY2 < UsbDisplayLinkDev->LastY1)) {
     UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
     return EFI_SUCCESS;
   }
 
-  UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
+  // Lock so that we take a consistent copy of the lines that have been BLTted to.
+  OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
 
-  EFI_TPL OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+  FirstY = MIN (UsbDisplayLinkDev->LastY1, Height);
+  LastY = MIN (UsbDisplayLinkDev->LastY2, Height);
+  LinesChanged = 0;
 
-  UINTN DataLen;
-  UINTN Width;
-  UINTN Height;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcPtr;
-  UINT8* DstPtr;
-  UINT8 DstBuffer[1920 * 3]; // Get rid of the magic numbers at some point
-                             // Could also use a buffer allocated at runtime to store the line, stored in the USB_DISPLAYLINK_DEV structure.
-  UINTN H;
+  for (H = FirstY; H < LastY; H++) {
+    SrcPtr = UsbDisplayLinkDev->Screen + H * Width;
+    DstPtr = UsbDisplayLinkDev->SentScreen + H * DataLen;
+    LineChanged = FALSE;
 
-  DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
-  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
-  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
-  SrcPtr = UsbDisplayLinkDev->Screen;
-  DstPtr = DstBuffer;
-
-  for (H = 0; H < Height; H++) {
-    DstPtr = DstBuffer;
-
-    UINTN W;
     for (W = 0; W < Width; W++) {
       // Need to swap round the RGB values
-      DstPtr[0] = ((UINT8 *)SrcPtr)[2];
-      DstPtr[1] = ((UINT8 *)SrcPtr)[1];
-      DstPtr[2] = ((UINT8 *)SrcPtr)[0];
+      if ((DstPtr[0] != SrcPtr->Red) || (DstPtr[1] != SrcPtr->Green) || (DstPtr[2] != SrcPtr->Blue)) {
+        DstPtr[0] = SrcPtr->Red;
+        DstPtr[1] = SrcPtr->Green;
+        DstPtr[2] = SrcPtr->Blue;
+        LineChanged = TRUE;
+      }
       SrcPtr++;
       DstPtr += 3;
     }
 
-    Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, DataLen, &USBStatus);
+    if (LineChanged) {
+      LinesChanged++;
+    }
+  }
+
+  // Reset the values that store which area of the screen has been BLTted to.
+  // If the transfer below fails, FullScreenUpdate makes us resend the frame after the next poll period.
+  UsbDisplayLinkDev->LastY2 = 0;
+  UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+
+  gBS->RestoreTPL (OriginalTPL);
+
+  // Everything BLTted since the last update was already on the screen (e.g. the shell redrawing the same text).
+  if (!UsbDisplayLinkDev->FullScreenUpdate && (LinesChanged == 0)) {
+    UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
+    return EFI_SUCCESS;
+  }
+
+  UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
+  UsbDisplayLinkDev->FullScreenUpdate = FALSE;
+
+  // The device only takes whole frames, one line per bulk transfer.
+  LinePtr = UsbDisplayLinkDev->SentScreen;
+  BytesSent = 0;
+
+  for (H = 0; H < Height; H++) {
+    Status = DlUsbBulkWrite (UsbDisplayLinkDev, LinePtr, DataLen, &USBStatus);
 
     // USBStatus values defined in usbio.h, e.g. EFI_USB_ERR_TIMEOUT 0x40
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
       break;
     }
+    BytesSent += DataLen;
+
     // Need an extra DlUsbBulkWrite if the data length is divisible by USB MaxPacketSize. This spare data will just get written into the (invisible) stride area.
     // Note that the API doesn't let us do a bulk write of 0.
     if ((DataLen & (UsbDisplayLinkDev->BulkOutEndpointDescriptor.MaxPacketSize - 1)) == 0) {
-      Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 2, &USBStatus);
+      Status = DlUsbBulkWrite (UsbDisplayLinkDev, LinePtr, 2, &USBStatus);
       if (EFI_ERROR (Status)) {
         DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
         break;
       }
+      BytesSent += 2;
     }
+
+    LinePtr += DataLen;
   }
 
-  if (!EFI_ERROR (Status)) {
-    // If we've successfully transmitted the frame, reset the values that store which area of the screen has been BLTted to.
-    // If we haven't succeeded, this will mean we'll try to resend it after the next poll period.
-    UsbDisplayLinkDev->LastY2 = 0;
-    UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+  if (EFI_ERROR (Status)) {
+    UsbDisplayLinkDev->FullScreenUpdate = TRUE;
   }
 
   // Payload with length of 1 to terminate the frame
   // We need to do this even if we had an error, to indicate to the DL device that it should now expect a new frame.
-  DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 1, &USBStatus);
+  DlUsbBulkWrite (UsbDisplayLinkDev, UsbDisplayLinkDev->SentScreen, 1, &USBStatus);
+  BytesSent += 1;
 
-  gBS->RestoreTPL (OriginalTPL);
+  UsbDisplayLinkDev->DataSent += BytesSent;
+  DEBUG ((DEBUG_VERBOSE, "Screen update - %Lu of %Lu lines changed, %Lu bytes sent\n", (UINT64)LinesChanged, (UINT64)Height, (UINT64)BytesSent));
 
   return Status;
 }
@@ -486,6 +549,20 @@ DisplayLinkSetMode (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  if (UsbDisplayLinkDev->SentScreen != NULL) {
+    FreePool (UsbDisplayLinkDev->SentScreen);
+  }
+
+  UsbDisplayLinkDev->SentScreen = (UINT8*)AllocateZeroPool (
+    Gop->Mode->Info->HorizontalResolution *
+    Gop->Mode->Info->VerticalResolution * 3);
+
+  if (UsbDisplayLinkDev->SentScreen == NULL) {
+    FreePool (UsbDisplayLinkDev->Screen);
+    UsbDisplayLinkDev->Screen = NULL;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
   DEBUG ((DEBUG_INFO, "Video mode %d selected by BIOS - %d x %d.\n", ModeNumber, VideoMode->HActive, VideoMode->VActive));
   // Wait until we are sure that we can set the video mode before we tell the firmware
   Status = DlUsbSendControlWriteMessage (UsbDisplayLinkDev, SET_VIDEO_MODE, 0, VideoMode, sizeof (struct VideoMode));
@@ -496,7 +573,11 @@ DisplayLinkSetMode (
     Gop->Mode->Mode = GRAPHICS_OUTPUT_INVALID_MODE_NUMBER;
     FreePool (UsbDisplayLinkDev->Screen);
     UsbDisplayLinkDev->Screen = NULL;
+    FreePool (UsbDisplayLinkDev->SentScreen);
+    UsbDisplayLinkDev->SentScreen = NULL;
   } else {
+    // The device has nothing of ours on screen yet
+    UsbDisplayLinkDev->FullScreenUpdate = TRUE;
     BuildBackBuffer (
       UsbDisplayLinkDev,
       UsbDisplayLinkDev->Screen,
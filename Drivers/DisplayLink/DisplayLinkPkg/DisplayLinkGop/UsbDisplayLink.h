@@ -79,7 +79,8 @@ typedef struct {
   EFI_EDID_DISCOVERED_PROTOCOL  EdidDiscovered;
   EFI_EDID_ACTIVE_PROTOCOL      EdidActive;
   EFI_UNICODE_STRING_TABLE      *ControllerNameTable;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Screen;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Screen;                        /** Back buffer, written by Blt */
+  UINT8                         *SentScreen;                   /** Front buffer - the last frame sent to the device, at 24 bits per pixel */
   UINTN                         DataSent;                       /** Debug - used to track the bandwidth */
   EFI_EVENT                     TimerEvent;
   EFI_EVENT                     DriverExitBootServicesEvent;
@@ -89,6 +90,7 @@ typedef struct {
   UINTN                         LastY2;
   UINTN                         LastWidth;
   UINTN                         TimeSinceLastScreenUpdate;     /** Do a full screen update every (x) seconds */
+  BOOLEAN                       FullScreenUpdate;              /** The device may not be showing SentScreen, so send it even if nothing changed */
 } USB_DISPLAYLINK_DEV;
 
 #define USB_DISPLAYLINK_DEV_SIGNATURE SIGNATURE_32 ('d', 'l', 'i', 'n')
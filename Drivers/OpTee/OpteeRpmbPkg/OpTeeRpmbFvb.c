@@ -110,6 +110,95 @@ ReadWriteRpmb (
   return Status;
 }
 
+/**
+  Commits the range of the in-memory copy that was written by
+  OpTeeRpmbFvbWrite() but not yet sent to the RPMB.
+
+  If the write fails, the range of the memory copy is reloaded from the RPMB,
+  since the writes it holds were already reported as successful. If that
+  fails too, the instance is marked as failed and all further accesses
+  return EFI_DEVICE_ERROR.
+
+  @param[in,out] Instance    MEM_INSTANCE pointer describing the device
+
+  @retval    EFI_SUCCESS     Nothing was pending or the range was written
+  @retval    Others          See ReadWriteRpmb()
+**/
+STATIC
+EFI_STATUS
+FlushDirtyRange (
+  IN OUT MEM_INSTANCE *Instance
+  )
+{
+  EFI_STATUS Status;
+  EFI_STATUS ReloadStatus;
+
+  if (Instance->DirtyStart == Instance->DirtyEnd) {
+    return EFI_SUCCESS;
+  }
+
+  Status = ReadWriteRpmb (
+             SP_SVC_RPMB_WRITE,
+             (UINTN)Instance->MemBaseAddress + Instance->DirtyStart,
+             Instance->DirtyEnd - Instance->DirtyStart,
+             Instance->DirtyStart
+             );
+  if (EFI_ERROR (Status)) {
+    ReloadStatus = ReadWriteRpmb (
+                     SP_SVC_RPMB_READ,
+                     (UINTN)Instance->MemBaseAddress + Instance->DirtyStart,
+                     Instance->DirtyEnd - Instance->DirtyStart,
+                     Instance->DirtyStart
+                     );
+    if (EFI_ERROR (ReloadStatus)) {
+      DEBUG ((DEBUG_ERROR, "%a: Failed to reload the memory copy: %r\n",
+        __FUNCTION__, ReloadStatus));
+      Instance->DeviceError = TRUE;
+    }
+  }
+
+  Instance->DirtyStart = 0;
+  Instance->DirtyEnd   = 0;
+
+  return Status;
+}
+
+/**
+  Root MMI handler, run at the end of every MMI. Commits the writes that
+  were deferred while handling it, so that they have all reached the RPMB
+  before control returns to the normal world.
+
+  @param[in]     DispatchHandle  The unique handle assigned to this handler
+  @param[in]     Context         Not used
+  @param[in,out] CommBuffer      Not used
+  @param[in,out] CommBufferSize  Not used
+
+  @retval EFI_SUCCESS            Always
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+OpTeeRpmbFlushHandler (
+  IN     EFI_HANDLE  DispatchHandle,
+  IN     CONST VOID  *Context         OPTIONAL,
+  IN OUT VOID        *CommBuffer      OPTIONAL,
+  IN OUT UINTN       *CommBufferSize  OPTIONAL
+  )
+{
+  EFI_STATUS Status;
+
+  Status = FlushDirtyRange (&mInstance);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to commit variable store writes: %r\n",
+      __FUNCTION__, Status));
+  }
+
+  // Now that we know pending writes get committed at the end of every MMI
+  mInstance.CoalesceWrites = TRUE;
+
+  return EFI_SUCCESS;
+}
+
 /**
   The GetAttributes() function retrieves the attributes and
   current settings of the block.
@@ -304,6 +393,9 @@ OpTeeRpmbFvbRead (
       return Status;
     }
   }
+  if (Instance->DeviceError) {
+    return EFI_DEVICE_ERROR;
+  }
 
   Base = (VOID *)(UINTN)Instance->MemBaseAddress + (Lba * Instance->BlockSize) +
          Offset;
@@ -380,6 +472,7 @@ OpTeeRpmbFvbWrite (
   MEM_INSTANCE *Instance;
   EFI_STATUS   Status;
   VOID         *Base;
+  UINTN        WriteOffset;
 
   Instance = INSTANCE_FROM_FVB_THIS (This);
   if (!Instance->Initialized) {
@@ -388,13 +481,45 @@ OpTeeRpmbFvbWrite (
       return Status;
     }
   }
-  Base = (VOID *)(UINTN)Instance->MemBaseAddress + (Lba * Instance->BlockSize) +
-         Offset;
+  if (Instance->DeviceError) {
+    return EFI_DEVICE_ERROR;
+  }
+  WriteOffset = (Lba * Instance->BlockSize) + Offset;
+  Base = (VOID *)(UINTN)Instance->MemBaseAddress + WriteOffset;
+
+  // The variable driver updates a variable with several small writes that
+  // mostly follow each other. A write that carries on exactly where the
+  // pending range ends, in the same block, is only made to the memory copy
+  // and is committed along with the pending range in a single RPMB write.
+  // Anything else commits the pending range first, so the RPMB still sees
+  // the writes in the order they were made.
+  if (Instance->CoalesceWrites &&
+      (WriteOffset + *NumBytes <= PcdGet32 (PcdFlashNvStorageVariableSize)) &&
+      ((Instance->DirtyStart == Instance->DirtyEnd) ||
+       ((WriteOffset == Instance->DirtyEnd) &&
+        (Lba == Instance->DirtyStart / Instance->BlockSize)))) {
+    if (Instance->DirtyStart == Instance->DirtyEnd) {
+      Instance->DirtyStart = WriteOffset;
+    }
+    Instance->DirtyEnd = WriteOffset + *NumBytes;
+
+    // Update the memory copy
+    CopyMem (Base, Buffer, *NumBytes);
+
+    return EFI_SUCCESS;
+  }
+
+  Status = FlushDirtyRange (Instance);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Writes to the FTW working and spare areas are always written through
   Status = ReadWriteRpmb (
              SP_SVC_RPMB_WRITE,
              (UINTN)Buffer,
              *NumBytes,
-             (Lba * Instance->BlockSize) + Offset
+             WriteOffset
              );
   if (EFI_ERROR (Status)) {
     return Status;
@@ -469,6 +594,14 @@ OpTeeRpmbFvbErase (
   EFI_STATUS Status;
 
   Instance = INSTANCE_FROM_FVB_THIS (This);
+  if (Instance->DeviceError) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = FlushDirtyRange (Instance);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
   VA_START (Args, This);
   for (Start = VA_ARG (Args, EFI_LBA);
@@ -861,6 +994,19 @@ OpTeeRpmbFvbInit (
                     );
   ASSERT_EFI_ERROR (Status);
 
+  // Writes are only coalesced once this handler has run, if it can't be
+  // registered every write goes straight to the RPMB.
+  Status = gMmst->MmiHandlerRegister (
+                    OpTeeRpmbFlushHandler,
+                    NULL,
+                    &mInstance.FlushHandle
+                    );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a: Failed to register the MMI handler: %r\n",
+      __FUNCTION__, Status));
+    Status = EFI_SUCCESS;
+  }
+
   DEBUG ((DEBUG_INFO, "%a: Register OP-TEE RPMB Fvb\n", __FUNCTION__));
   DEBUG ((DEBUG_INFO, "%a: Using NV store FV in-memory copy at 0x%lx\n",
     __FUNCTION__, PatchPcdGet64 (PcdFlashNvStorageVariableBase64)));
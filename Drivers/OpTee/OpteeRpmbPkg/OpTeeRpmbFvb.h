@@ -58,6 +58,16 @@ struct _MEM_INSTANCE
     UINT16                              BlockSize;
     /// Number of allocated blocks
     UINT16                              NBlocks;
+    /// Set once the MMI handler that commits deferred writes has run
+    BOOLEAN                             CoalesceWrites;
+    /// Offset of the written but not yet committed range (DirtyStart == DirtyEnd if none)
+    UINTN                               DirtyStart;
+    /// End offset of the written but not yet committed range
+    UINTN                               DirtyEnd;
+    /// Handle of the root MMI handler that commits deferred writes
+    EFI_HANDLE                          FlushHandle;
+    /// Set if a failed commit left the memory copy out of step with the RPMB
+    BOOLEAN                             DeviceError;
 };
 
 #endif
@@ -0,0 +1,282 @@
+/** @file
+  Metadata block cache
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+/**
+  Compare two EXT4_BLOCK_CACHE_ENTRY structs.
+  Used in the block cache's ORDERED_COLLECTION.
+
+  @param[in] UserStruct1  Pointer to the first user structure.
+
+  @param[in] UserStruct2  Pointer to the second user structure.
+
+  @retval <0  If UserStruct1 compares less than UserStruct2.
+
+  @retval  0  If UserStruct1 compares equal to UserStruct2.
+
+  @retval >0  If UserStruct1 compares greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4BlockCacheStructCompare (
+  IN CONST VOID  *UserStruct1,
+  IN CONST VOID  *UserStruct2
+  )
+{
+  CONST EXT4_BLOCK_CACHE_ENTRY  *Entry1;
+  CONST EXT4_BLOCK_CACHE_ENTRY  *Entry2;
+
+  Entry1 = UserStruct1;
+  Entry2 = UserStruct2;
+
+  return Entry1->BlockNumber < Entry2->BlockNumber ? -1 :
+         Entry1->BlockNumber > Entry2->BlockNumber ? 1 : 0;
+}
+
+/**
+  Compare a standalone key against a EXT4_BLOCK_CACHE_ENTRY containing an embedded key.
+  Used in the block cache's ORDERED_COLLECTION.
+
+  @param[in] StandaloneKey  Pointer to the bare key (a pointer to an EXT4_BLOCK_NR).
+
+  @param[in] UserStruct     Pointer to the user structure with the embedded
+                            key.
+
+  @retval <0  If StandaloneKey compares less than UserStruct's key.
+
+  @retval  0  If StandaloneKey compares equal to UserStruct's key.
+
+  @retval >0  If StandaloneKey compares greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4BlockCacheKeyCompare (
+  IN CONST VOID  *StandaloneKey,
+  IN CONST VOID  *UserStruct
+  )
+{
+  CONST EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  EXT4_BLOCK_NR                 Block;
+
+  // Block numbers are 64-bit, so we can't pass them by value on 32-bit architectures.
+  Entry = UserStruct;
+  Block = *(CONST EXT4_BLOCK_NR *)StandaloneKey;
+
+  return Block < Entry->BlockNumber ? -1 :
+         Block > Entry->BlockNumber ? 1 : 0;
+}
+
+/**
+   Initialises the (empty) metadata block cache of the partition.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE  *Cache;
+
+  Cache = &Partition->BlockCache;
+
+  InitializeListHead (&Cache->LruList);
+  Cache->NumberEntries = 0;
+  Cache->MaxEntries    = 0;
+  Cache->Hits          = 0;
+  Cache->Misses        = 0;
+
+  Cache->Index = OrderedCollectionInit (Ext4BlockCacheStructCompare, Ext4BlockCacheKeyCompare);
+  if (Cache->Index == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the metadata block cache of the partition, deleting every cached block.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  LIST_ENTRY              *Node;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+
+  Cache = &Partition->BlockCache;
+
+  if (Cache->Index == NULL) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_FS,
+    "[ext4] Block cache: %lu hits, %lu misses\n",
+    Cache->Hits,
+    Cache->Misses
+    ));
+
+  while (!IsListEmpty (&Cache->LruList)) {
+    Node  = GetFirstNode (&Cache->LruList);
+    Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE (Node);
+
+    RemoveEntryList (Node);
+    OrderedCollectionDelete (Cache->Index, Entry->IndexEntry, NULL);
+    FreePool (Entry);
+  }
+
+  ASSERT (OrderedCollectionIsEmpty (Cache->Index));
+
+  OrderedCollectionUninit (Cache->Index);
+  Cache->Index         = NULL;
+  Cache->NumberEntries = 0;
+}
+
+/**
+   Gets a cache entry we can fill with a new block, either by allocating a new
+   one or by recycling the least recently used entry.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+
+   @return Pointer to an unlinked cache entry, or NULL if we're out of memory.
+**/
+STATIC
+EXT4_BLOCK_CACHE_ENTRY *
+Ext4GetFreeBlockCacheEntry (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  LIST_ENTRY              *Node;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+
+  Cache = &Partition->BlockCache;
+
+  // The cache's size depends on the block size, which we only know after reading the superblock.
+  if (Cache->MaxEntries == 0) {
+    Cache->MaxEntries = MAX (EXT4_BLOCK_CACHE_SIZE / Partition->BlockSize, EXT4_BLOCK_CACHE_MIN_ENTRIES);
+  }
+
+  if (Cache->NumberEntries < Cache->MaxEntries) {
+    Entry = AllocatePool (sizeof (EXT4_BLOCK_CACHE_ENTRY) + Partition->BlockSize);
+
+    if (Entry != NULL) {
+      Cache->NumberEntries++;
+      return Entry;
+    }
+
+    // Under memory pressure, try to recycle an older entry instead.
+  }
+
+  if (IsListEmpty (&Cache->LruList)) {
+    return NULL;
+  }
+
+  // The tail of the list holds the least recently used block
+  Node  = GetPreviousNode (&Cache->LruList, &Cache->LruList);
+  Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE (Node);
+
+  RemoveEntryList (Node);
+  OrderedCollectionDelete (Cache->Index, Entry->IndexEntry, NULL);
+
+  return Entry;
+}
+
+/**
+   Reads part of a metadata block through the partition's block cache.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  BlockNumber    Physical block number.
+   @param[in]  Offset         Offset inside the block, in bytes.
+   @param[in]  Length         Length of the read, in bytes.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedBlock (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN EXT4_BLOCK_NR   BlockNumber,
+  IN UINTN           Offset,
+  IN UINTN           Length
+  )
+{
+  EXT4_BLOCK_CACHE          *Cache;
+  ORDERED_COLLECTION_ENTRY  *IndexEntry;
+  EXT4_BLOCK_CACHE_ENTRY    *Entry;
+  EFI_STATUS                Status;
+
+  Cache = &Partition->BlockCache;
+
+  if ((Offset > Partition->BlockSize) || (Length > Partition->BlockSize - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  IndexEntry = OrderedCollectionFind (Cache->Index, &BlockNumber);
+
+  if (IndexEntry != NULL) {
+    Entry = OrderedCollectionUserStruct (IndexEntry);
+    Cache->Hits++;
+
+    // Move it to the head of the LRU list
+    RemoveEntryList (&Entry->LruNode);
+    InsertHeadList (&Cache->LruList, &Entry->LruNode);
+
+    CopyMem (Buffer, EXT4_BLOCK_CACHE_ENTRY_DATA (Entry) + Offset, Length);
+    return EFI_SUCCESS;
+  }
+
+  Cache->Misses++;
+
+  Entry = Ext4GetFreeBlockCacheEntry (Partition);
+
+  if (Entry == NULL) {
+    // Can't cache it, so just do a regular read.
+    return Ext4ReadDiskIo (
+             Partition,
+             Buffer,
+             Length,
+             EXT4_BLOCK_TO_BYTES (Partition, BlockNumber) + Offset
+             );
+  }
+
+  Status = Ext4ReadBlocks (Partition, EXT4_BLOCK_CACHE_ENTRY_DATA (Entry), 1, BlockNumber);
+
+  if (EFI_ERROR (Status)) {
+    Cache->NumberEntries--;
+    FreePool (Entry);
+    return Status;
+  }
+
+  Entry->BlockNumber = BlockNumber;
+
+  Status = OrderedCollectionInsert (Cache->Index, &Entry->IndexEntry, Entry);
+
+  if (EFI_ERROR (Status)) {
+    // We looked it up just before, so this can only be an allocation failure.
+    Cache->NumberEntries--;
+    CopyMem (Buffer, EXT4_BLOCK_CACHE_ENTRY_DATA (Entry) + Offset, Length);
+    FreePool (Entry);
+    return EFI_SUCCESS;
+  }
+
+  InsertHeadList (&Cache->LruList, &Entry->LruNode);
+
+  CopyMem (Buffer, EXT4_BLOCK_CACHE_ENTRY_DATA (Entry) + Offset, Length);
+  return EFI_SUCCESS;
+}
@@ -27,6 +27,189 @@ Ext4GetBlockGroupDesc (
   return (EXT4_BLOCK_GROUP_DESC *)((CHAR8 *)Partition->BlockGroups + BlockGroup * Partition->DescSize);
 }
 
+/**
+   Checks a block group descriptor: verifies its checksum and makes sure its
+   inode table lies inside the filesystem.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  BlockGroup     Block group number.
+
+   @return TRUE if the descriptor is valid, FALSE if there is corruption.
+**/
+STATIC
+BOOLEAN
+Ext4CheckBlockGroupDesc (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN UINT32                BlockGroup
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT64                 InodeTableBlocks;
+
+  Desc = Ext4GetBlockGroupDesc ((EXT4_PARTITION *)Partition, BlockGroup);
+
+  if (!Ext4VerifyBlockGroupDescChecksum (Partition, Desc, BlockGroup)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %u has an invalid checksum\n", BlockGroup));
+    return FALSE;
+  }
+
+  InodeTableBlocks = DivU64x32 (
+                       MultU64x32 (Partition->SuperBlock.s_inodes_per_group, Partition->InodeSize) +
+                       Partition->BlockSize - 1,
+                       Partition->BlockSize
+                       );
+
+  if ((Partition->InodeTables[BlockGroup] >= Partition->NumberBlocks) ||
+      (Partition->NumberBlocks - Partition->InodeTables[BlockGroup] < InodeTableBlocks))
+  {
+    DEBUG ((DEBUG_ERROR, "[ext4] Block group %u has an out of bounds inode table\n", BlockGroup));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+   Reads the block group descriptor table and decodes every block group's
+   inode table location into a flat array.
+
+   Descriptors are verified right away, unless the filesystem has more than
+   EXT4_BLOCK_GROUPS_EAGER_VERIFY_MAX block groups; in that case, they're
+   verified the first time they're used.
+
+   @param[in out]  Partition  Pointer to the opened ext4 partition.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4InitBlockGroups (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  UINT32                 NrBlocksRem;
+  UINTN                  NrBlocks;
+  UINT32                 Index;
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  BOOLEAN                VerifyNow;
+
+  NrBlocks = (UINTN)DivU64x32Remainder (
+                      MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize),
+                      Partition->BlockSize,
+                      &NrBlocksRem
+                      );
+
+  if (NrBlocksRem != 0) {
+    NrBlocks++;
+  }
+
+  // The descriptor table starts right after the superblock's block
+  Partition->BlockGroups = Ext4AllocAndReadBlocks (Partition, NrBlocks, Partition->BlockSize == 1024 ? 2 : 1);
+
+  if (Partition->BlockGroups == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Partition->InodeTables = AllocatePool ((UINTN)Partition->NumberBlockGroups * sizeof (EXT4_BLOCK_NR));
+
+  if (Partition->InodeTables == NULL) {
+    Ext4FreeBlockGroups (Partition);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  VerifyNow = Partition->NumberBlockGroups <= EXT4_BLOCK_GROUPS_EAGER_VERIFY_MAX;
+
+  if (!VerifyNow) {
+    Partition->VerifiedBlockGroups = AllocateZeroPool ((UINTN)DivU64x32 (Partition->NumberBlockGroups + 7, 8));
+
+    if (Partition->VerifiedBlockGroups == NULL) {
+      Ext4FreeBlockGroups (Partition);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  // Note: flex_bg doesn't need any special handling here, since descriptors
+  // always hold absolute block numbers.
+  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
+    Desc = Ext4GetBlockGroupDesc (Partition, Index);
+
+    Partition->InodeTables[Index] = EXT4_BLOCK_NR_FROM_HALFS (
+                                      Partition,
+                                      Desc->bg_inode_table_lo,
+                                      Desc->bg_inode_table_hi
+                                      );
+
+    if (VerifyNow && !Ext4CheckBlockGroupDesc (Partition, Index)) {
+      Ext4FreeBlockGroups (Partition);
+      return EFI_VOLUME_CORRUPTED;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the block group descriptor table and the data decoded from it.
+
+   @param[in out]  Partition  Pointer to the opened ext4 partition.
+**/
+VOID
+Ext4FreeBlockGroups (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  if (Partition->BlockGroups != NULL) {
+    FreePool (Partition->BlockGroups);
+    Partition->BlockGroups = NULL;
+  }
+
+  if (Partition->InodeTables != NULL) {
+    FreePool (Partition->InodeTables);
+    Partition->InodeTables = NULL;
+  }
+
+  if (Partition->VerifiedBlockGroups != NULL) {
+    FreePool (Partition->VerifiedBlockGroups);
+    Partition->VerifiedBlockGroups = NULL;
+  }
+}
+
+/**
+   Retrieves the location of a block group's inode table,
+   verifying the block group's descriptor if needed.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  BlockGroup     Block group number.
+   @param[out] InodeTable     Pointer to the inode table's first block.
+
+   @retval EFI_SUCCESS            The inode table was found.
+   @retval EFI_VOLUME_CORRUPTED   The block group's descriptor is corrupted.
+**/
+STATIC
+EFI_STATUS
+Ext4GetBlockGroupInodeTable (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT32          BlockGroup,
+  OUT EXT4_BLOCK_NR   *InodeTable
+  )
+{
+  UINT8  Mask;
+
+  if (Partition->VerifiedBlockGroups != NULL) {
+    Mask = (UINT8)(1 << (BlockGroup % 8));
+
+    if ((Partition->VerifiedBlockGroups[BlockGroup / 8] & Mask) == 0) {
+      if (!Ext4CheckBlockGroupDesc (Partition, BlockGroup)) {
+        return EFI_VOLUME_CORRUPTED;
+      }
+
+      Partition->VerifiedBlockGroups[BlockGroup / 8] |= Mask;
+    }
+  }
+
+  *InodeTable = Partition->InodeTables[BlockGroup];
+  return EFI_SUCCESS;
+}
+
 /**
    Reads an inode from disk.
 
@@ -43,12 +226,14 @@ Ext4ReadInode (
   OUT EXT4_INODE     **OutIno
   )
 {
-  UINT64                 InodeOffset;
-  UINT32                 BlockGroupNumber;
-  EXT4_INODE             *Inode;
-  EXT4_BLOCK_GROUP_DESC  *BlockGroup;
-  EXT4_BLOCK_NR          InodeTableStart;
-  EFI_STATUS             Status;
+  UINT64         InodeOffset;
+  UINT32         BlockGroupNumber;
+  EXT4_INODE     *Inode;
+  EXT4_BLOCK_NR  InodeTableStart;
+  EFI_STATUS     Status;
+  UINT64         InodeTableOffset;
+  UINT32         InodeBlockOffset;
+  EXT4_BLOCK_NR  InodeBlock;
 
   if (!EXT4_IS_VALID_INODE_NR (Partition, InodeNum)) {
     DEBUG ((DEBUG_ERROR, "[ext4] Error reading inode: inode number %lu isn't valid\n", InodeNum));
@@ -66,28 +251,34 @@ Ext4ReadInode (
     return EFI_VOLUME_CORRUPTED;
   }
 
+  // Note: We'll need to check INODE_UNINIT and friends when/if we add write support
+  Status = Ext4GetBlockGroupInodeTable (Partition, BlockGroupNumber, &InodeTableStart);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   Inode = Ext4AllocateInode (Partition);
 
   if (Inode == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  BlockGroup = Ext4GetBlockGroupDesc (Partition, BlockGroupNumber);
-
-  // Note: We'll need to check INODE_UNINIT and friends when/if we add write support
-
-  InodeTableStart = EXT4_BLOCK_NR_FROM_HALFS (
-                      Partition,
-                      BlockGroup->bg_inode_table_lo,
-                      BlockGroup->bg_inode_table_hi
-                      );
-
-  Status = Ext4ReadDiskIo (
-             Partition,
-             Inode,
-             Partition->InodeSize,
-             EXT4_BLOCK_TO_BYTES (Partition, InodeTableStart) + MultU64x32 (InodeOffset, Partition->InodeSize)
-             );
+  InodeTableOffset = MultU64x32 (InodeOffset, Partition->InodeSize);
+  InodeBlock       = InodeTableStart + DivU64x32Remainder (InodeTableOffset, Partition->BlockSize, &InodeBlockOffset);
+
+  // Inode table blocks are read through the block cache, since neighbouring inodes
+  // (e.g. the files in the same directory) are very likely to be read next.
+  if (InodeBlockOffset + Partition->InodeSize <= Partition->BlockSize) {
+    Status = Ext4ReadCachedBlock (Partition, Inode, InodeBlock, InodeBlockOffset, Partition->InodeSize);
+  } else {
+    Status = Ext4ReadDiskIo (
+               Partition,
+               Inode,
+               Partition->InodeSize,
+               EXT4_BLOCK_TO_BYTES (Partition, InodeTableStart) + InodeTableOffset
+               );
+  }
 
   if (EFI_ERROR (Status)) {
     DEBUG ((
@@ -0,0 +1,191 @@
+/** @file
+  CRC32C implementation used for metadata checksums
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+// Reversed CRC32C (Castagnoli) polynomial
+#define EXT4_CRC32C_POLY  0x82F63B78U
+
+//
+// Slice-by-8 tables: mCrc32cTable[0] is the regular byte-wise table, and
+// mCrc32cTable[N][Byte] is the CRC of Byte followed by N zero bytes.
+//
+STATIC UINT32   mCrc32cTable[8][256];
+STATIC BOOLEAN  mCrc32cHwSupported;
+
+/**
+   Initialises the CRC32C tables and detects if the CPU has CRC32C instructions.
+   Must be called before Ext4Crc32c.
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  )
+{
+  UINT32  Index;
+  UINT32  Bit;
+  UINT32  Crc;
+  UINT32  Slice;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = Index;
+
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc >> 1) ^ ((Crc & 1) != 0 ? EXT4_CRC32C_POLY : 0);
+    }
+
+    mCrc32cTable[0][Index] = Crc;
+  }
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = mCrc32cTable[0][Index];
+
+    for (Slice = 1; Slice < 8; Slice++) {
+      Crc                        = mCrc32cTable[0][Crc & 0xFF] ^ (Crc >> 8);
+      mCrc32cTable[Slice][Index] = Crc;
+    }
+  }
+
+  mCrc32cHwSupported = Ext4Crc32cHwSupported ();
+
+  DEBUG ((DEBUG_FS, "[ext4] CRC32C instructions %a\n", mCrc32cHwSupported ? "supported" : "not supported"));
+}
+
+/**
+   Updates a CRC32C using the slice-by-8 tables.
+
+   @param[in]      Crc           Current (non-inverted) CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+STATIC
+UINT32
+Ext4Crc32cSliceBy8 (
+  IN UINT32       Crc,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  UINT32  Low;
+  UINT32  High;
+
+  // Get the buffer 4-byte aligned first
+  while ((Length != 0) && (((UINTN)Buffer & 3) != 0)) {
+    Crc = mCrc32cTable[0][(Crc ^ *Buffer++) & 0xFF] ^ (Crc >> 8);
+    Length--;
+  }
+
+  // Note: This assumes a little-endian CPU, like every architecture we support.
+  while (Length >= 8) {
+    Low  = *(CONST UINT32 *)Buffer ^ Crc;
+    High = *(CONST UINT32 *)(Buffer + 4);
+
+    Crc = mCrc32cTable[7][Low & 0xFF] ^
+          mCrc32cTable[6][(Low >> 8) & 0xFF] ^
+          mCrc32cTable[5][(Low >> 16) & 0xFF] ^
+          mCrc32cTable[4][Low >> 24] ^
+          mCrc32cTable[3][High & 0xFF] ^
+          mCrc32cTable[2][(High >> 8) & 0xFF] ^
+          mCrc32cTable[1][(High >> 16) & 0xFF] ^
+          mCrc32cTable[0][High >> 24];
+
+    Buffer += 8;
+    Length -= 8;
+  }
+
+  while (Length != 0) {
+    Crc = mCrc32cTable[0][(Crc ^ *Buffer++) & 0xFF] ^ (Crc >> 8);
+    Length--;
+  }
+
+  return Crc;
+}
+
+/**
+   Updates a CRC32C, using the CPU's CRC32C instructions if available.
+   Note that, like ext4 itself, this does not pre or post-invert the CRC.
+
+   @param[in]      Crc           Current (non-inverted) CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32c (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  if (mCrc32cHwSupported) {
+    return Ext4Crc32cHw (Crc, Buffer, Length);
+  }
+
+  return Ext4Crc32cSliceBy8 (Crc, Buffer, Length);
+}
+
+#if !defined (MDE_CPU_X64) && !defined (MDE_CPU_AARCH64)
+
+/**
+   Checks if the CPU supports CRC32C instructions.
+
+   @return TRUE if supported, else FALSE.
+**/
+BOOLEAN
+EFIAPI
+Ext4Crc32cHwSupported (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+   Updates a CRC32C using the CPU's CRC32C instructions.
+
+   @param[in]      Crc           Current (non-inverted) CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+EFIAPI
+Ext4Crc32cHw (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  ASSERT (FALSE);
+  return Ext4Crc32cSliceBy8 (Crc, Buffer, Length);
+}
+
+#elif defined (MDE_CPU_X64)
+
+/**
+   Checks if the CPU supports CRC32C instructions (SSE4.2).
+
+   @return TRUE if supported, else FALSE.
+**/
+BOOLEAN
+EFIAPI
+Ext4Crc32cHwSupported (
+  VOID
+  )
+{
+  UINT32  Ecx;
+
+  AsmCpuid (1, NULL, NULL, &Ecx, NULL);
+
+  return (Ecx & BIT20) != 0;
+}
+
+#endif
@@ -90,43 +90,152 @@ Ext4ValidDirent (
 }
 
 /**
-   Retrieves a directory entry.
+   Reads a directory block through the partition's block cache.
+
+   @param[in]      Partition     Pointer to the ext4 partition.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[out]     Buffer        Pointer to the destination buffer, Partition->BlockSize bytes long.
+   @param[in]      LogicalBlock  Logical block of the directory to read.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4ReadDirBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT VOID            *Buffer,
+  IN  EXT4_BLOCK_NR   LogicalBlock
+  )
+{
+  EFI_STATUS     Status;
+  EXT4_EXTENT    Extent;
+  EXT4_BLOCK_NR  PhysicalBlock;
+
+  Status = Ext4GetExtent (Partition, Directory, LogicalBlock, &Extent);
+
+  if ((Status == EFI_NO_MAPPING) || (!EFI_ERROR (Status) && EXT4_EXTENT_IS_UNINITIALIZED (&Extent))) {
+    // Holes (and uninitialized extents) read as zeroes, just like in Ext4Read
+    ZeroMem (Buffer, Partition->BlockSize);
+    return EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  PhysicalBlock = (LShiftU64 (Extent.ee_start_hi, 32) | Extent.ee_start_lo) + (LogicalBlock - Extent.ee_block);
+
+  return Ext4ReadCachedBlock (Partition, Buffer, PhysicalBlock, 0, Partition->BlockSize);
+}
+
+/**
+   Searches a directory block for a directory entry.
 
-   @param[in]      Directory   Pointer to the opened directory.
-   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
    @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
    @param[out]     Result      Pointer to the destination directory entry.
 
-   @return The result of the operation.
+   @retval EFI_SUCCESS          The entry was found and copied to Result.
+   @retval EFI_NOT_FOUND        The entry isn't present in this block.
+   @retval !EFI_SUCCESS         Other failure (e.g the block is corrupted).
 **/
 EFI_STATUS
-Ext4RetrieveDirent (
-  IN EXT4_FILE        *Directory,
-  IN CONST CHAR16     *Name,
-  IN EXT4_PARTITION   *Partition,
+Ext4SearchDirBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  CONST CHAR8     *Block,
+  IN  CONST CHAR16    *Name,
   OUT EXT4_DIR_ENTRY  *Result
   )
 {
   EFI_STATUS      Status;
-  CHAR8           *Buf;
-  UINT64          Off;
-  EXT4_INODE      *Inode;
-  UINT64          DirInoSize;
-  UINT32          BlockRemainder;
-  UINTN           Length;
   EXT4_DIR_ENTRY  *Entry;
   UINTN           RemainingBlock;
   CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
   UINTN           ToCopy;
   UINTN           BlockOffset;
 
-  Buf = AllocatePool (Partition->BlockSize);
+  for (BlockOffset = 0; BlockOffset < Partition->BlockSize; ) {
+    Entry          = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
+    RemainingBlock = Partition->BlockSize - BlockOffset;
+    // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
+    if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-  if (Buf == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+    if (!Ext4ValidDirent (Entry)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
+      // Corrupted filesystem
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    // Unused entry
+    if (Entry->inode == 0) {
+      BlockOffset += Entry->rec_len;
+      continue;
+    }
+
+    Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
+
+    /* In theory, this should never fail.
+     * In reality, it's quite possible that it can fail, considering filenames in
+     * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
+     * need to form valid ASCII/UTF-8 sequences.
+     */
+    if (EFI_ERROR (Status)) {
+      if (Status == EFI_INVALID_PARAMETER) {
+        // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
+        // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
+        BlockOffset += Entry->rec_len;
+        continue;
+      }
+
+      // Other sorts of errors should just error out.
+      return Status;
+    }
+
+    if ((Entry->name_len == StrLen (Name)) &&
+        !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
+    {
+      ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
+
+      CopyMem (Result, Entry, ToCopy);
+      return EFI_SUCCESS;
+    }
+
+    BlockOffset += Entry->rec_len;
   }
 
-  Off = 0;
+  return EFI_NOT_FOUND;
+}
+
+/**
+   Retrieves a directory entry.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @return The result of the operation.
+**/
+EFI_STATUS
+Ext4RetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       *Buf;
+  UINT64      Off;
+  EXT4_INODE  *Inode;
+  UINT64      DirInoSize;
+  UINT32      BlockRemainder;
 
   Inode      = Directory->Inode;
   DirInoSize = EXT4_INODE_SIZE (Inode);
@@ -134,151 +243,236 @@ Ext4RetrieveDirent (
   DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
   if (BlockRemainder != 0) {
     // Directory inodes need to have block aligned sizes
-    Status = EFI_VOLUME_CORRUPTED;
-    goto Out;
+    return EFI_VOLUME_CORRUPTED;
   }
 
-  while (Off < DirInoSize) {
-    Length = Partition->BlockSize;
+  if (EXT4_DIR_IS_INDEXED (Partition, Directory)) {
+    Status = Ext4HashTreeRetrieveDirent (Directory, Name, Partition, Result);
 
-    Status = Ext4Read (Partition, Directory, Buf, Off, &Length);
+    // Hash lookups are case-sensitive, while EFI file names are not, so a hash tree miss
+    // (or a broken hash tree) still needs to go through the linear scan below.
+    if (!EFI_ERROR (Status) || (Status == EFI_OUT_OF_RESOURCES) || (Status == EFI_DEVICE_ERROR)) {
+      return Status;
+    }
+  }
+
+  Buf = AllocatePool (Partition->BlockSize);
+
+  if (Buf == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Off = 0;
+
+  while (Off < DirInoSize) {
+    Status = Ext4ReadDirBlock (Partition, Directory, Buf, DivU64x32 (Off, Partition->BlockSize));
 
     if (Status != EFI_SUCCESS) {
       goto Out;
     }
 
-    for (BlockOffset = 0; BlockOffset < Partition->BlockSize; ) {
-      Entry          = (EXT4_DIR_ENTRY *)(Buf + BlockOffset);
-      RemainingBlock = Partition->BlockSize - BlockOffset;
-      // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
-      if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    Status = Ext4SearchDirBlock (Partition, Buf, Name, Result);
 
-      if (!Ext4ValidDirent (Entry)) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
+    }
 
-      if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
-        // Corrupted filesystem
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    Off += Partition->BlockSize;
+  }
 
-      // Unused entry
-      if (Entry->inode == 0) {
-        BlockOffset += Entry->rec_len;
-        continue;
-      }
+  Status = EFI_NOT_FOUND;
 
-      Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
+Out:
+  FreePool (Buf);
+  return Status;
+}
 
-      /* In theory, this should never fail.
-       * In reality, it's quite possible that it can fail, considering filenames in
-       * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
-       * need to form valid ASCII/UTF-8 sequences.
-       */
-      if (EFI_ERROR (Status)) {
-        if (Status == EFI_INVALID_PARAMETER) {
-          // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
-          // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
-          BlockOffset += Entry->rec_len;
-          continue;
-        }
+/**
+   Marks a dentry as recently used, adding it to the partition's dentry cache
+   (which holds a reference to it) if needed. Evicts the least recently used
+   dentries if the cache is full.
 
-        // Other sorts of errors should just error out.
-        FreePool (Buf);
-        return Status;
-      }
+   @param[in out]  Partition   Pointer to the ext4 partition.
+   @param[in out]  Dentry      Pointer to the dentry.
+**/
+STATIC
+VOID
+Ext4CacheDentry (
+  IN OUT EXT4_PARTITION  *Partition,
+  IN OUT EXT4_DENTRY     *Dentry
+  )
+{
+  LIST_ENTRY   *Node;
+  EXT4_DENTRY  *Victim;
 
-      if ((Entry->name_len == StrLen (Name)) &&
-          !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
-      {
-        ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
+  // The root dentry lives as long as the partition does
+  if (Dentry->Parent == NULL) {
+    return;
+  }
 
-        CopyMem (Result, Entry, ToCopy);
-        Status = EFI_SUCCESS;
-        goto Out;
-      }
+  if (Dentry->InLru) {
+    RemoveEntryList (&Dentry->LruNode);
+    InsertHeadList (&Partition->DentryLru, &Dentry->LruNode);
+    return;
+  }
 
-      BlockOffset += Entry->rec_len;
+  Ext4RefDentry (Dentry);
+  InsertHeadList (&Partition->DentryLru, &Dentry->LruNode);
+  Dentry->InLru = TRUE;
+  Partition->NumberCachedDentries++;
+
+  while (Partition->NumberCachedDentries > EXT4_DENTRY_CACHE_SIZE) {
+    Node   = GetPreviousNode (&Partition->DentryLru, &Partition->DentryLru);
+    Victim = EXT4_DENTRY_FROM_LRU_NODE (Node);
+
+    RemoveEntryList (Node);
+    Victim->InLru = FALSE;
+    Partition->NumberCachedDentries--;
+
+    Ext4UnrefDentry (Victim);
+  }
+}
+
+/**
+   Drops every dentry from the partition's dentry cache.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FlushDentryCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  LIST_ENTRY   *Node;
+  EXT4_DENTRY  *Dentry;
+
+  while (!IsListEmpty (&Partition->DentryLru)) {
+    Node   = GetFirstNode (&Partition->DentryLru);
+    Dentry = EXT4_DENTRY_FROM_LRU_NODE (Node);
+
+    RemoveEntryList (Node);
+    Dentry->InLru = FALSE;
+    Ext4UnrefDentry (Dentry);
+  }
+
+  Partition->NumberCachedDentries = 0;
+}
+
+/**
+   Finds a child of a directory's dentry that was already opened (and
+   therefore has a cached inode) under the given name.
+
+   @param[in]      Parent      Pointer to the directory's dentry.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+
+   @return Pointer to the dentry, or NULL if it wasn't found.
+**/
+STATIC
+EXT4_DENTRY *
+Ext4FindCachedDentry (
+  IN EXT4_DENTRY   *Parent,
+  IN CONST CHAR16  *Name
+  )
+{
+  LIST_ENTRY   *Node;
+  EXT4_DENTRY  *Child;
+
+  BASE_LIST_FOR_EACH (Node, &Parent->Children) {
+    Child = EXT4_DENTRY_FROM_DENTRY_LIST (Node);
+
+    if ((Child->CachedInode != NULL) && (StrLen (Child->Name) == StrLen (Name)) &&
+        !Ext4StrCmpInsensitive (Child->Name, (CHAR16 *)Name))
+    {
+      return Child;
     }
+  }
 
-    Off += Partition->BlockSize;
+  return NULL;
+}
+
+/**
+   Gets a private copy of a file's inode, from its dentry's cache if possible.
+   On a cache miss, the inode is read (and validated) and then cached in the dentry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in out]  Dentry      Pointer to the file's dentry.
+   @param[in]      InodeNum    Number of the inode.
+   @param[out]     OutIno      Pointer where to store the pointer to the inode.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4GetDentryInode (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_DENTRY     *Dentry,
+  IN     EXT4_INO_NR     InodeNum,
+  OUT    EXT4_INODE      **OutIno
+  )
+{
+  EFI_STATUS  Status;
+  EXT4_INODE  *Inode;
+
+  if ((Dentry->CachedInode == NULL) || (Dentry->Inode != InodeNum)) {
+    Status = Ext4ReadInode (Partition, InodeNum, &Inode);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (Dentry->CachedInode != NULL) {
+      FreePool (Dentry->CachedInode);
+    }
+
+    Dentry->CachedInode = Inode;
+    Dentry->Inode       = InodeNum;
   }
 
-  Status = EFI_NOT_FOUND;
+  Inode = Ext4AllocateInode (Partition);
 
-Out:
-  FreePool (Buf);
-  return Status;
+  if (Inode == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (Inode, Dentry->CachedInode, MAX (Partition->InodeSize, sizeof (EXT4_INODE)));
+
+  *OutIno = Inode;
+  return EFI_SUCCESS;
 }
 
 /**
-   Opens a file using a directory entry.
+   Opens a file using its dentry.
 
    @param[in]      Partition   Pointer to the ext4 partition.
    @param[in]      OpenMode    Mode in which the file is supposed to be open.
    @param[out]     OutFile     Pointer to the newly opened file.
-   @param[in]      Entry       Directory entry to be used.
-   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Dentry      Pointer to the file's dentry. The caller's reference
+                               to it is handed over to the file, even on failure.
+   @param[in]      InodeNum    Number of the file's inode.
 
    @retval EFI_STATUS          Result of the operation
 **/
+STATIC
 EFI_STATUS
-Ext4OpenDirent (
+Ext4OpenDentry (
   IN  EXT4_PARTITION  *Partition,
   IN  UINT64          OpenMode,
   OUT EXT4_FILE       **OutFile,
-  IN  EXT4_DIR_ENTRY  *Entry,
-  IN  EXT4_FILE       *Directory
+  IN  EXT4_DENTRY     *Dentry,
+  IN  EXT4_INO_NR     InodeNum
   )
 {
   EFI_STATUS  Status;
-  CHAR16      FileName[EXT4_NAME_MAX + 1];
   EXT4_FILE   *File;
 
   File = AllocateZeroPool (sizeof (EXT4_FILE));
 
   if (File == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Error;
-  }
-
-  Status = Ext4GetUcs2DirentName (Entry, FileName);
-
-  if (EFI_ERROR (Status)) {
-    goto Error;
+    Ext4UnrefDentry (Dentry);
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  if (StrCmp (FileName, L".") == 0) {
-    // We're using the parent directory's dentry
-    File->Dentry = Directory->Dentry;
-
-    ASSERT (File->Dentry != NULL);
-
-    Ext4RefDentry (File->Dentry);
-  } else if (StrCmp (FileName, L"..") == 0) {
-    // Using the parent's parent's dentry
-    File->Dentry = Directory->Dentry->Parent;
-
-    if (!File->Dentry) {
-      // Someone tried .. on root, so direct them to /
-      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
-      File->Dentry = Directory->Dentry;
-    }
-
-    Ext4RefDentry (File->Dentry);
-  } else {
-    File->Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
-
-    if (File->Dentry == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Error;
-    }
-  }
+  File->Dentry = Dentry;
 
   Status = Ext4InitExtentsMap (File);
 
@@ -286,11 +480,11 @@ Ext4OpenDirent (
     goto Error;
   }
 
-  File->InodeNum = Entry->inode;
+  File->InodeNum = InodeNum;
 
   Ext4SetupFile (File, Partition);
 
-  Status = Ext4ReadInode (Partition, Entry->inode, &File->Inode);
+  Status = Ext4GetDentryInode (Partition, Dentry, InodeNum, &File->Inode);
 
   if (EFI_ERROR (Status)) {
     goto Error;
@@ -303,19 +497,77 @@ Ext4OpenDirent (
   return EFI_SUCCESS;
 
 Error:
-  if (File != NULL) {
-    if (File->Dentry != NULL) {
-      Ext4UnrefDentry (File->Dentry);
-    }
+  Ext4UnrefDentry (File->Dentry);
+  Ext4FreeExtentsMap (File);
+  FreePool (File);
+
+  return Status;
+}
+
+/**
+   Opens a file using a directory entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      OpenMode    Mode in which the file is supposed to be open.
+   @param[out]     OutFile     Pointer to the newly opened file.
+   @param[in]      Entry       Directory entry to be used.
+   @param[in]      Directory   Pointer to the opened directory.
+
+   @retval EFI_STATUS          Result of the operation
+**/
+EFI_STATUS
+Ext4OpenDirent (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT64          OpenMode,
+  OUT EXT4_FILE       **OutFile,
+  IN  EXT4_DIR_ENTRY  *Entry,
+  IN  EXT4_FILE       *Directory
+  )
+{
+  EFI_STATUS   Status;
+  CHAR16       FileName[EXT4_NAME_MAX + 1];
+  EXT4_DENTRY  *Dentry;
+
+  Status = Ext4GetUcs2DirentName (Entry, FileName);
 
-    if (File->ExtentsMap != NULL) {
-      OrderedCollectionUninit (File->ExtentsMap);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (StrCmp (FileName, L".") == 0) {
+    // We're using the parent directory's dentry
+    Dentry = Directory->Dentry;
+
+    ASSERT (Dentry != NULL);
+
+    Ext4RefDentry (Dentry);
+  } else if (StrCmp (FileName, L"..") == 0) {
+    // Using the parent's parent's dentry
+    Dentry = Directory->Dentry->Parent;
+
+    if (!Dentry) {
+      // Someone tried .. on root, so direct them to /
+      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
+      Dentry = Directory->Dentry;
     }
 
-    FreePool (File);
+    Ext4RefDentry (Dentry);
+  } else {
+    // Reuse the cached dentry if this file was opened before
+    Dentry = Ext4FindCachedDentry (Directory->Dentry, FileName);
+
+    if ((Dentry != NULL) && (Dentry->Inode == Entry->inode) && (StrCmp (Dentry->Name, FileName) == 0)) {
+      Ext4RefDentry (Dentry);
+    } else {
+      Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
+
+      if (Dentry == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
   }
 
-  return Status;
+  return Ext4OpenDentry (Partition, OpenMode, OutFile, Dentry, Entry->inode);
 }
 
 /**
@@ -339,20 +591,38 @@ Ext4OpenFile (
   )
 {
   EXT4_DIR_ENTRY  Entry;
+  EXT4_DENTRY     *Dentry;
   EFI_STATUS      Status;
 
-  Status = Ext4RetrieveDirent (Directory, Name, Partition, &Entry);
+  // If the file was opened recently, we can skip both the directory lookup and the
+  // inode read (and its checksum verification).
+  Dentry = Ext4FindCachedDentry (Directory->Dentry, Name);
 
-  if (EFI_ERROR (Status)) {
-    return Status;
+  if (Dentry != NULL) {
+    Ext4RefDentry (Dentry);
+    Status = Ext4OpenDentry (Partition, OpenMode, OutFile, Dentry, Dentry->Inode);
+  } else {
+    Status = Ext4RetrieveDirent (Directory, Name, Partition, &Entry);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    // EFI requires us to error out on ".." opens for the root directory
+    if (Entry.inode == Directory->InodeNum) {
+      return EFI_NOT_FOUND;
+    }
+
+    Status = Ext4OpenDirent (Partition, OpenMode, OutFile, &Entry, Directory);
   }
 
-  // EFI requires us to error out on ".." opens for the root directory
-  if (Entry.inode == Directory->InodeNum) {
-    return EFI_NOT_FOUND;
+  // Only lookups populate the dentry cache. ReadDir() opens every entry of a
+  // directory once, and would otherwise evict the files that get reopened.
+  if (!EFI_ERROR (Status)) {
+    Ext4CacheDentry (Partition, (*OutFile)->Dentry);
   }
 
-  return Ext4OpenDirent (Partition, OpenMode, OutFile, &Entry, Directory);
+  return Status;
 }
 
 /**
@@ -448,20 +718,25 @@ Ext4ReadDir (
   IN OUT UINTN       *OutLength
   )
 {
-  EXT4_INODE      *DirIno;
-  EFI_STATUS      Status;
-  UINT64          DirInoSize;
-  UINTN           Len;
-  UINT32          BlockRemainder;
-  EXT4_DIR_ENTRY  Entry;
-  EXT4_FILE       *TempFile;
-  BOOLEAN         ShouldSkip;
-  BOOLEAN         IsDotOrDotDot;
-  CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
+  EXT4_INODE       *DirIno;
+  EFI_STATUS       Status;
+  UINT64           DirInoSize;
+  UINTN            Len;
+  UINT32           BlockRemainder;
+  EXT4_DIR_ENTRY   Entry;
+  EXT4_FILE        *TempFile;
+  BOOLEAN          ShouldSkip;
+  BOOLEAN          IsDotOrDotDot;
+  CHAR16           DirentUcs2Name[EXT4_NAME_MAX + 1];
+  EXT4_DIR_CURSOR  *Cursor;
+  EXT4_BLOCK_NR    LogicalBlock;
+  UINT32           BlockOffset;
+  UINTN            RemainingBlock;
 
   DirIno     = File->Inode;
   Status     = EFI_SUCCESS;
   DirInoSize = EXT4_INODE_SIZE (DirIno);
+  Cursor     = &File->DirCursor;
 
   DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
   if (BlockRemainder != 0) {
@@ -472,28 +747,53 @@ Ext4ReadDir (
   while (TRUE) {
     TempFile = NULL;
 
-    // We (try to) read the maximum size of a directory entry at a time
-    // Note that we don't need to read any padding that may exist after it.
-    Len    = sizeof (Entry);
-    Status = Ext4Read (Partition, File, &Entry, Offset, &Len);
-
-    if (EFI_ERROR (Status)) {
-      goto Out;
-    }
-
-    if (Len == 0) {
+    if (Offset >= DirInoSize) {
       *OutLength = 0;
       Status     = EFI_SUCCESS;
       goto Out;
     }
 
+    // Directory entries never cross block boundaries, so we keep the directory block
+    // we're in around, and each entry is just a step inside it.
+    LogicalBlock = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOffset);
+
+    if (!Cursor->Valid || (Cursor->LogicalBlock != LogicalBlock)) {
+      if (Cursor->Block == NULL) {
+        Cursor->Block = AllocatePool (Partition->BlockSize);
+
+        if (Cursor->Block == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          goto Out;
+        }
+      }
+
+      Cursor->Valid = FALSE;
+
+      Status = Ext4ReadDirBlock (Partition, File, Cursor->Block, LogicalBlock);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      Cursor->LogicalBlock = LogicalBlock;
+      Cursor->Valid        = TRUE;
+    }
+
+    RemainingBlock = Partition->BlockSize - BlockOffset;
+
+    // We (try to) copy the maximum size of a directory entry at a time
+    // Note that we don't need to copy any padding that may exist after it.
+    Len = MIN (RemainingBlock, sizeof (Entry));
+
     if (Len < EXT4_MIN_DIR_ENTRY_LEN) {
       Status = EFI_VOLUME_CORRUPTED;
       goto Out;
     }
 
+    CopyMem (&Entry, Cursor->Block + BlockOffset, Len);
+
     // Invalid directory entry length
-    if (!Ext4ValidDirent (&Entry)) {
+    if (!Ext4ValidDirent (&Entry) || (Entry.rec_len > RemainingBlock)) {
       DEBUG ((DEBUG_ERROR, "[ext4] Invalid dirent at offset %lu\n", Offset));
       Status = EFI_VOLUME_CORRUPTED;
       goto Out;
@@ -675,11 +975,17 @@ Ext4DeleteDentry (
   IN OUT EXT4_DENTRY  *Dentry
   )
 {
+  ASSERT (!Dentry->InLru);
+
   if (Dentry->Parent) {
     Ext4RemoveDentry (Dentry->Parent, Dentry);
     Ext4UnrefDentry (Dentry->Parent);
   }
 
+  if (Dentry->CachedInode != NULL) {
+    FreePool (Dentry->CachedInode);
+  }
+
   DEBUG ((DEBUG_FS, "[ext4] Deleted dentry %s\n", Dentry->Name));
   FreePool (Dentry);
 }
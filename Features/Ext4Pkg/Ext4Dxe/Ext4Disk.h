@@ -68,7 +68,8 @@
           mostly-list of EXT4_DIR_ENTRY.
        2) Hash tree directories: These are used for larger directories, with
           hundreds of entries, and are designed in a backwards compatible way.
-          These are not yet implemented in the Ext4Dxe driver.
+          Ext4Dxe uses the hash tree to speed up lookups, but otherwise treats
+          these directories as linear ones.
 
   7) Journal
      Ext3/4 filesystems have a journal to help protect the filesystem against
@@ -424,6 +425,60 @@ typedef struct {
 
 #define EXT4_MIN_DIR_ENTRY_LEN  8
 
+// Superblock s_flags
+#define EXT4_FLAGS_SIGNED_HASH    0x0001
+#define EXT4_FLAGS_UNSIGNED_HASH  0x0002
+#define EXT4_FLAGS_TEST_FILESYS   0x0004
+
+// Hash tree (dir_index) hash versions
+#define EXT4_DX_HASH_LEGACY             0
+#define EXT4_DX_HASH_HALF_MD4           1
+#define EXT4_DX_HASH_TEA                2
+#define EXT4_DX_HASH_LEGACY_UNSIGNED    3
+#define EXT4_DX_HASH_HALF_MD4_UNSIGNED  4
+#define EXT4_DX_HASH_TEA_UNSIGNED       5
+#define EXT4_DX_HASH_SIPHASH            6
+
+// Hash tree nodes hold 3 levels at most with largedir, otherwise 2
+#define EXT4_DX_MAX_LEVELS          3
+#define EXT4_DX_MAX_LEVELS_COMPAT   2
+#define EXT4_DX_ROOT_INFO_LENGTH    8
+#define EXT4_DX_BLOCK_MASK          0x0FFFFFFF
+
+// This on-disk structure follows the "." and ".." entries in the hash tree's root block
+typedef struct {
+  UINT32    reserved_zero;
+  UINT8     hash_version;
+  // Length of this structure; must be EXT4_DX_ROOT_INFO_LENGTH
+  UINT8     info_length;
+  // Depth of the hash tree, not counting the leaves
+  UINT8     indirect_levels;
+  UINT8     unused_flags;
+} EXT4_DX_ROOT_INFO;
+
+typedef struct {
+  // Hash of the first entry covered by the block
+  UINT32    hash;
+  // Logical block of the directory
+  UINT32    block;
+} EXT4_DX_ENTRY;
+
+// This on-disk structure overlays the first EXT4_DX_ENTRY's hash field
+typedef struct {
+  UINT16    limit;
+  UINT16    count;
+} EXT4_DX_COUNT_LIMIT;
+
+// Present after the last possible EXT4_DX_ENTRY on metadata_csum filesystems
+typedef struct {
+  UINT32    dt_reserved;
+  UINT32    dt_checksum;
+} EXT4_DX_TAIL;
+
+// The hash tree root starts with fixed-size "." and ".." entries
+#define EXT4_DX_DOT_ENTRY_LEN     12
+#define EXT4_DX_ROOT_INFO_OFFSET  (2 * EXT4_DX_DOT_ENTRY_LEN)
+
 // This on-disk structure is present at the bottom of the extent tree
 typedef struct {
   // First logical block
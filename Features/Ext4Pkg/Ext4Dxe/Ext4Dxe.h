@@ -77,6 +77,43 @@ Ext4OpenPartition (
 typedef struct _Ext4File     EXT4_FILE;
 typedef struct _Ext4_Dentry  EXT4_DENTRY;
 
+//
+// Size of the metadata block cache, in bytes. The cache holds at least
+// EXT4_BLOCK_CACHE_MIN_ENTRIES blocks, regardless of the block size.
+//
+#define EXT4_BLOCK_CACHE_SIZE         SIZE_256KB
+#define EXT4_BLOCK_CACHE_MIN_ENTRIES  8
+
+/**
+   A cached metadata block. The block's contents follow the structure.
+**/
+typedef struct {
+  LIST_ENTRY                  LruNode;
+  ORDERED_COLLECTION_ENTRY    *IndexEntry;
+  EXT4_BLOCK_NR               BlockNumber;
+} EXT4_BLOCK_CACHE_ENTRY;
+
+#define EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE(Node)  BASE_CR(Node, EXT4_BLOCK_CACHE_ENTRY, LruNode)
+#define EXT4_BLOCK_CACHE_ENTRY_DATA(Entry)          ((UINT8 *)((Entry) + 1))
+
+/**
+   Bounded LRU cache of metadata blocks (inode tables, extent tree nodes and
+   directory blocks), keyed by physical block number.
+**/
+typedef struct {
+  // Most recently used entries are at the head of the list
+  LIST_ENTRY            LruList;
+  ORDERED_COLLECTION    *Index;
+  UINTN                 NumberEntries;
+  UINTN                 MaxEntries;
+  UINT64                Hits;
+  UINT64                Misses;
+} EXT4_BLOCK_CACHE;
+
+// Filesystems with up to this many block groups get every block group
+// descriptor verified at mount time; bigger ones are verified on first use.
+#define EXT4_BLOCK_GROUPS_EAGER_VERIFY_MAX  8192
+
 typedef struct _Ext4_PARTITION {
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL    Interface;
   EFI_DISK_IO_PROTOCOL               *DiskIo;
@@ -97,6 +134,10 @@ typedef struct _Ext4_PARTITION {
 
   EXT4_BLOCK_GROUP_DESC              *BlockGroups;
   UINT32                             DescSize;
+  // First block of each block group's inode table, decoded from BlockGroups
+  EXT4_BLOCK_NR                      *InodeTables;
+  // Bitmap of verified block group descriptors, if verification is done lazily
+  UINT8                              *VerifiedBlockGroups;
   EXT4_FILE                          *Root;
 
   UINT32                             InitialSeed;
@@ -104,14 +145,26 @@ typedef struct _Ext4_PARTITION {
   LIST_ENTRY                         OpenFiles;
 
   EXT4_DENTRY                        *RootDentry;
+
+  EXT4_BLOCK_CACHE                   BlockCache;
+
+  // Dentries recently looked up by Open(), most recently used first. Each holds a reference.
+  LIST_ENTRY                         DentryLru;
+  UINTN                              NumberCachedDentries;
 } EXT4_PARTITION;
 
+//
+// Number of recently opened dentries (and their inodes) kept alive after
+// their files are closed.
+//
+#define EXT4_DENTRY_CACHE_SIZE  64
+
 /**
    This structure represents a directory entry inside our directory entry tree.
-   For now, it will be used as a way to track file names inside our opening
-   code, but it may very well be used as a directory cache in the future.
-   Because it's not being used as a directory cache right now,
-   an EXT4_DENTRY structure is not necessarily unique name-wise in the list of
+   It's used to track file names inside our opening code, and as a cache of
+   recently opened files: a dentry that has a CachedInode can be opened again
+   without looking it up in its directory or re-reading its inode.
+   An EXT4_DENTRY structure is not necessarily unique name-wise in the list of
    children. Therefore, the dentry tree does not accurately reflect the
    filesystem structure.
  */
@@ -122,9 +175,15 @@ struct _Ext4_Dentry {
   struct _Ext4_Dentry    *Parent;
   LIST_ENTRY             Children;
   LIST_ENTRY             ListNode;
+
+  // Validated copy of the inode, or NULL if it hasn't been read yet
+  EXT4_INODE             *CachedInode;
+  BOOLEAN                InLru;
+  LIST_ENTRY             LruNode;
 };
 
 #define EXT4_DENTRY_FROM_DENTRY_LIST(Node)  BASE_CR(Node, EXT4_DENTRY, ListNode)
+#define EXT4_DENTRY_FROM_LRU_NODE(Node)     BASE_CR(Node, EXT4_DENTRY, LruNode)
 
 /**
    Creates a new dentry object.
@@ -164,6 +223,16 @@ Ext4UnrefDentry (
   IN OUT EXT4_DENTRY  *Dentry
   );
 
+/**
+   Drops every dentry from the partition's dentry cache.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FlushDentryCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
 /**
    Opens and parses the superblock.
 
@@ -264,6 +333,48 @@ Ext4AllocAndReadBlocks (
   IN EXT4_BLOCK_NR   BlockNumber
   );
 
+/**
+   Initialises the (empty) metadata block cache of the partition.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the metadata block cache of the partition, deleting every cached block.
+
+   @param[in out]  Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Reads part of a metadata block through the partition's block cache.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  BlockNumber    Physical block number.
+   @param[in]  Offset         Offset inside the block, in bytes.
+   @param[in]  Length         Length of the read, in bytes.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedBlock (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN EXT4_BLOCK_NR   BlockNumber,
+  IN UINTN           Offset,
+  IN UINTN           Length
+  );
+
 /**
    Checks if the opened partition has the 64-bit feature (see
 EXT4_FEATURE_INCOMPAT_64BIT).
@@ -301,6 +412,29 @@ Ext4GetBlockGroupDesc (
   IN UINT32          BlockGroup
   );
 
+/**
+   Reads the block group descriptor table and decodes every block group's
+   inode table location into a flat array.
+
+   @param[in out]  Partition  Pointer to the opened ext4 partition.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4InitBlockGroups (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the block group descriptor table and the data decoded from it.
+
+   @param[in out]  Partition  Pointer to the opened ext4 partition.
+**/
+VOID
+Ext4FreeBlockGroups (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
 /**
    Checks inode number validity across superblock of the opened partition.
 
@@ -360,6 +494,16 @@ Ext4Read (
   IN OUT UINTN           *Length
   );
 
+/**
+   Frees the file's read-ahead buffer.
+
+   @param[in out]  File          Pointer to the opened file.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_FILE  *File
+  );
+
 /**
    Retrieves the size of the inode.
 
@@ -390,6 +534,54 @@ Ext4GetExtent (
   OUT EXT4_EXTENT    *Extent
   );
 
+//
+// Initial capacity of a file's extent map, in extents.
+//
+#define EXT4_EXTENT_MAP_MIN_CAPACITY  16
+
+/**
+   Cache of a file's extents, as an array sorted by logical block.
+**/
+typedef struct {
+  EXT4_EXTENT    *Extents;
+  UINTN          NumberExtents;
+  UINTN          Capacity;
+} EXT4_EXTENT_MAP;
+
+//
+// Sequential read-ahead window bounds, in bytes. The window starts at
+// EXT4_READAHEAD_MIN_WINDOW and doubles on every refill while the file is
+// being read sequentially.
+//
+#define EXT4_READAHEAD_MIN_WINDOW  SIZE_64KB
+#define EXT4_READAHEAD_MAX_WINDOW  SIZE_2MB
+
+/**
+   Per-file read-ahead state.
+**/
+typedef struct {
+  // Buffered file data, [Start, Start + Length)
+  UINT8     *Buffer;
+  UINTN     BufferSize;
+  UINT64    Start;
+  UINTN     Length;
+
+  // Current read-ahead window; 0 if the file isn't being read sequentially
+  UINTN     Window;
+  // Offset at which the next sequential read would start
+  UINT64    NextOffset;
+} EXT4_READAHEAD;
+
+/**
+   Per-file directory reading state: the directory block ReadDir() is going through.
+**/
+typedef struct {
+  // Partition->BlockSize bytes, allocated on the first ReadDir()
+  CHAR8            *Block;
+  EXT4_BLOCK_NR    LogicalBlock;
+  BOOLEAN          Valid;
+} EXT4_DIR_CURSOR;
+
 struct _Ext4File {
   EFI_FILE_PROTOCOL     Protocol;
   EXT4_INODE            *Inode;
@@ -401,7 +593,11 @@ struct _Ext4File {
 
   EXT4_PARTITION        *Partition;
 
-  ORDERED_COLLECTION    *ExtentsMap;
+  EXT4_EXTENT_MAP       ExtentsMap;
+
+  EXT4_READAHEAD        ReadAhead;
+
+  EXT4_DIR_CURSOR       DirCursor;
 
   LIST_ENTRY            OpenFilesListNode;
 
@@ -432,6 +628,78 @@ Ext4RetrieveDirent (
   OUT EXT4_DIR_ENTRY  *Result
   );
 
+/**
+   Reads a directory block through the partition's block cache.
+
+   @param[in]      Partition     Pointer to the ext4 partition.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[out]     Buffer        Pointer to the destination buffer, Partition->BlockSize bytes long.
+   @param[in]      LogicalBlock  Logical block of the directory to read.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4ReadDirBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT VOID            *Buffer,
+  IN  EXT4_BLOCK_NR   LogicalBlock
+  );
+
+/**
+   Searches a directory block for a directory entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS          The entry was found and copied to Result.
+   @retval EFI_NOT_FOUND        The entry isn't present in this block.
+   @retval !EFI_SUCCESS         Other failure (e.g the block is corrupted).
+**/
+EFI_STATUS
+Ext4SearchDirBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  CONST CHAR8     *Block,
+  IN  CONST CHAR16    *Name,
+  OUT EXT4_DIR_ENTRY  *Result
+  );
+
+/**
+   Checks if a directory is indexed by a hash tree (and if we're allowed to use it).
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+
+   @return TRUE if the directory is indexed, else FALSE.
+**/
+#define EXT4_DIR_IS_INDEXED(Partition, Directory)                              \
+  (EXT4_HAS_COMPAT (Partition, EXT4_FEATURE_COMPAT_DIR_INDEX) &&               \
+   (((Directory)->Inode->i_flags & EXT4_INDEX_FL) != 0))
+
+/**
+   Retrieves a directory entry using the directory's hash tree.
+
+   @param[in]      Directory   Pointer to the opened (indexed) directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         The entry isn't indexed under its name's hash.
+   @retval EFI_VOLUME_CORRUPTED  The hash tree is corrupted.
+   @retval EFI_UNSUPPORTED       The hash tree uses an unsupported hash.
+   @retval !EFI_SUCCESS          Other failure.
+**/
+EFI_STATUS
+Ext4HashTreeRetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  );
+
 /**
    Opens a file.
 
@@ -1040,6 +1308,62 @@ Ext4FreeExtentsMap (
   IN EXT4_FILE  *File
   );
 
+/**
+   Initialises the CRC32C tables and detects if the CPU has CRC32C instructions.
+   Must be called before Ext4Crc32c.
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  );
+
+/**
+   Updates a CRC32C, using the CPU's CRC32C instructions if available.
+   Note that, like ext4 itself, this does not pre or post-invert the CRC.
+
+   @param[in]      Crc           Current (non-inverted) CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32c (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
+/**
+   Checks if the CPU supports CRC32C instructions.
+   Implemented per architecture.
+
+   @return TRUE if supported, else FALSE.
+**/
+BOOLEAN
+EFIAPI
+Ext4Crc32cHwSupported (
+  VOID
+  );
+
+/**
+   Updates a CRC32C using the CPU's CRC32C instructions.
+   Implemented per architecture; must only be called if Ext4Crc32cHwSupported() is TRUE.
+
+   @param[in]      Crc           Current (non-inverted) CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+EFIAPI
+Ext4Crc32cHw (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
 /**
    Calculates the checksum of the given buffer.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
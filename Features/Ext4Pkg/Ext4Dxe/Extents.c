@@ -34,7 +34,7 @@ Ext4CalculateExtentChecksum (
   );
 
 /**
-   Caches a range of extents, by allocating pool memory for each extent and adding it to the tree.
+   Caches a range of extents, by inserting them into the file's sorted extent array.
 
    @param[in]      File        Pointer to the open file.
    @param[in]      Extents     Pointer to an array of extents.
@@ -54,6 +54,7 @@ Ext4CacheExtents (
    @param[in]      Block         Block we want to grab.
 
    @return Pointer to the extent, or NULL if it was not found.
+           The pointer is only valid until the next Ext4CacheExtents.
 **/
 EXT4_EXTENT *
 Ext4GetExtentFromMap (
@@ -309,7 +310,7 @@ Ext4GetExtent (
     }
 
     // Read the leaf block onto the previously-allocated buffer.
-    Status = Ext4ReadBlocks (Partition, Buffer, 1, BlockNumber);
+    Status = Ext4ReadCachedBlock (Partition, Buffer, BlockNumber, 0, Partition->BlockSize);
     if (EFI_ERROR (Status)) {
       FreePool (Buffer);
       return Status;
@@ -370,74 +371,40 @@ Ext4GetExtent (
 }
 
 /**
-  Compare two EXT4_EXTENT structs.
-  Used in the extent map's ORDERED_COLLECTION.
+   Finds the position of the last cached extent that starts at or before Block.
 
-  @param[in] UserStruct1  Pointer to the first user structure.
+   @param[in]      Map         Pointer to the extent map.
+   @param[in]      Block       Logical block.
 
-  @param[in] UserStruct2  Pointer to the second user structure.
-
-  @retval <0  If UserStruct1 compares less than UserStruct2.
-
-  @retval  0  If UserStruct1 compares equal to UserStruct2.
-
-  @retval >0  If UserStruct1 compares greater than UserStruct2.
+   @return Index of the extent, or -1 if every extent starts after Block
+           (or the map is empty).
 **/
 STATIC
 INTN
-EFIAPI
-Ext4ExtentsMapStructCompare (
-  IN CONST VOID  *UserStruct1,
-  IN CONST VOID  *UserStruct2
+Ext4ExtentsMapSearch (
+  IN CONST EXT4_EXTENT_MAP  *Map,
+  IN UINT32                 Block
   )
 {
-  CONST EXT4_EXTENT  *Extent1;
-  CONST EXT4_EXTENT  *Extent2;
-
-  Extent1 = UserStruct1;
-  Extent2 = UserStruct2;
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
 
-  return Extent1->ee_block < Extent2->ee_block ? -1 :
-         Extent1->ee_block > Extent2->ee_block ? 1 : 0;
-}
-
-/**
-  Compare a standalone key against a EXT4_EXTENT containing an embedded key.
-  Used in the extent map's ORDERED_COLLECTION.
-
-  @param[in] StandaloneKey  Pointer to the bare key.
-
-  @param[in] UserStruct     Pointer to the user structure with the embedded
-                            key.
-
-  @retval <0  If StandaloneKey compares less than UserStruct's key.
-
-  @retval  0  If StandaloneKey compares equal to UserStruct's key.
-
-  @retval >0  If StandaloneKey compares greater than UserStruct's key.
-**/
-STATIC
-INTN
-EFIAPI
-Ext4ExtentsMapKeyCompare (
-  IN CONST VOID  *StandaloneKey,
-  IN CONST VOID  *UserStruct
-  )
-{
-  CONST EXT4_EXTENT  *Extent;
-  UINT32             Block;
+  // Binary search for the first extent that starts after Block, in [Low, High)
+  Low  = 0;
+  High = Map->NumberExtents;
 
-  // Note that logical blocks are 32-bits in size so no truncation can happen here
-  // with regards to 32-bit architectures.
-  Extent = UserStruct;
-  Block  = (UINT32)(UINTN)StandaloneKey;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
 
-  if ((Block >= Extent->ee_block) && (Block - Extent->ee_block < Ext4GetExtentLength (Extent))) {
-    return 0;
+    if (Map->Extents[Middle].ee_block > Block) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
   }
 
-  return Block < Extent->ee_block ? -1 :
-         Block > Extent->ee_block ? 1 : 0;
+  return (INTN)Low - 1;
 }
 
 /**
@@ -452,10 +419,10 @@ Ext4InitExtentsMap (
   IN EXT4_FILE  *File
   )
 {
-  File->ExtentsMap = OrderedCollectionInit (Ext4ExtentsMapStructCompare, Ext4ExtentsMapKeyCompare);
-  if (!File->ExtentsMap) {
-    return EFI_OUT_OF_RESOURCES;
-  }
+  // The array is only allocated once we cache the first extent.
+  File->ExtentsMap.Extents       = NULL;
+  File->ExtentsMap.NumberExtents = 0;
+  File->ExtentsMap.Capacity      = 0;
 
   return EFI_SUCCESS;
 }
@@ -470,27 +437,58 @@ Ext4FreeExtentsMap (
   IN EXT4_FILE  *File
   )
 {
-  // Keep calling Min(), so we get an arbitrary node we can delete.
-  // If Min() returns NULL, it's empty.
+  if (File->ExtentsMap.Extents != NULL) {
+    FreePool (File->ExtentsMap.Extents);
+  }
+
+  Ext4InitExtentsMap (File);
+}
+
+/**
+   Makes sure the extents map has room for NumberExtents more extents.
+
+   @param[in out]  Map           Pointer to the extent map.
+   @param[in]      NumberExtents Number of extents we want to add.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4GrowExtentsMap (
+  IN OUT EXT4_EXTENT_MAP  *Map,
+  IN     UINTN            NumberExtents
+  )
+{
+  UINTN        NewCapacity;
+  EXT4_EXTENT  *NewExtents;
+
+  if (Map->Capacity - Map->NumberExtents >= NumberExtents) {
+    return EFI_SUCCESS;
+  }
 
-  ORDERED_COLLECTION_ENTRY  *MinEntry;
-  EXT4_EXTENT               *Ext;
+  // Grow geometrically, so that caching a file's extents leaf by leaf
+  // only takes a logarithmic number of allocations.
+  NewCapacity = MAX (Map->Capacity * 2, EXT4_EXTENT_MAP_MIN_CAPACITY);
+  NewCapacity = MAX (NewCapacity, Map->NumberExtents + NumberExtents);
 
-  MinEntry = NULL;
+  NewExtents = ReallocatePool (
+                 Map->Capacity * sizeof (EXT4_EXTENT),
+                 NewCapacity * sizeof (EXT4_EXTENT),
+                 Map->Extents
+                 );
 
-  while ((MinEntry = OrderedCollectionMin (File->ExtentsMap)) != NULL) {
-    OrderedCollectionDelete (File->ExtentsMap, MinEntry, (VOID **)&Ext);
-    FreePool (Ext);
+  if (NewExtents == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  ASSERT (OrderedCollectionIsEmpty (File->ExtentsMap));
+  Map->Extents  = NewExtents;
+  Map->Capacity = NewCapacity;
 
-  OrderedCollectionUninit (File->ExtentsMap);
-  File->ExtentsMap = NULL;
+  return EFI_SUCCESS;
 }
 
 /**
-   Caches a range of extents, by allocating pool memory for each extent and adding it to the tree.
+   Caches a range of extents, by inserting them into the file's sorted extent array.
 
    @param[in]      File        Pointer to the open file.
    @param[in]      Extents     Pointer to an array of extents.
@@ -503,34 +501,39 @@ Ext4CacheExtents (
   IN UINT16             NumberExtents
   )
 {
-  UINT16       Idx;
-  EXT4_EXTENT  *Extent;
-  EFI_STATUS   Status;
+  EXT4_EXTENT_MAP  *Map;
+  UINT16           Idx;
+  INTN             Position;
+
+  Map = &File->ExtentsMap;
 
-  /* Note that any out of memory condition might mean we don't get to cache a whole leaf of extents
-   * in which case, future insertions might fail.
-   */
+  // If we run out of memory, we just don't cache this leaf.
+  if (EFI_ERROR (Ext4GrowExtentsMap (Map, NumberExtents))) {
+    return;
+  }
 
   for (Idx = 0; Idx < NumberExtents; Idx++, Extents++) {
-    Extent = AllocatePool (sizeof (EXT4_EXTENT));
+    Position = Ext4ExtentsMapSearch (Map, Extents->ee_block);
 
-    if (Extent == NULL) {
-      return;
+    // Already cached
+    if ((Position >= 0) && (Map->Extents[Position].ee_block == Extents->ee_block)) {
+      continue;
     }
 
-    CopyMem (Extent, Extents, sizeof (EXT4_EXTENT));
-    Status = OrderedCollectionInsert (File->ExtentsMap, NULL, Extent);
-
-    // EFI_ALREADY_STARTED = already exists in the tree.
-    if (EFI_ERROR (Status)) {
-      FreePool (Extent);
-
-      if (Status == EFI_ALREADY_STARTED) {
-        continue;
-      }
+    // Insert it right after Position. Files tend to be read front to back,
+    // so this is usually an append.
+    Position++;
 
-      return;
+    if ((UINTN)Position < Map->NumberExtents) {
+      CopyMem (
+        &Map->Extents[Position + 1],
+        &Map->Extents[Position],
+        (Map->NumberExtents - Position) * sizeof (EXT4_EXTENT)
+        );
     }
+
+    CopyMem (&Map->Extents[Position], Extents, sizeof (EXT4_EXTENT));
+    Map->NumberExtents++;
   }
 }
 
@@ -541,6 +544,7 @@ Ext4CacheExtents (
    @param[in]      Block         Block we want to grab.
 
    @return Pointer to the extent, or NULL if it was not found.
+           The pointer is only valid until the next Ext4CacheExtents.
 **/
 EXT4_EXTENT *
 Ext4GetExtentFromMap (
@@ -548,15 +552,22 @@ Ext4GetExtentFromMap (
   IN UINT32     Block
   )
 {
-  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_EXTENT  *Extent;
+  INTN         Position;
+
+  Position = Ext4ExtentsMapSearch (&File->ExtentsMap, Block);
+
+  if (Position < 0) {
+    return NULL;
+  }
 
-  Entry = OrderedCollectionFind (File->ExtentsMap, (CONST VOID *)(UINTN)Block);
+  Extent = &File->ExtentsMap.Extents[Position];
 
-  if (Entry == NULL) {
+  if (Block - Extent->ee_block >= Ext4GetExtentLength (Extent)) {
     return NULL;
   }
 
-  return OrderedCollectionUserStruct (Entry);
+  return Extent;
 }
 
 /**
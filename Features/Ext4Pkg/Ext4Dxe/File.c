@@ -437,6 +437,12 @@ Ext4CloseInternal (
   RemoveEntryList (&File->OpenFilesListNode);
   FreePool (File->Inode);
   Ext4FreeExtentsMap (File);
+  Ext4FreeReadAhead (File);
+
+  if (File->DirCursor.Block != NULL) {
+    FreePool (File->DirCursor.Block);
+  }
+
   Ext4UnrefDentry (File->Dentry);
   FreePool (File);
   return EFI_SUCCESS;
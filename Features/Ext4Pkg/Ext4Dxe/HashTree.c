@@ -0,0 +1,754 @@
+/** @file
+  Hash tree (dir_index) directory lookups
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  The hash functions below follow the ext4 documentation at
+  https://www.kernel.org/doc/html/latest/filesystems/ext4/dynamic.html#hash-tree-directories
+  and are bit-compatible with the Linux implementation.
+**/
+
+#include "Ext4Dxe.h"
+
+#include <Library/BaseUcs2Utf8Lib.h>
+
+#define EXT4_DX_TEA_DELTA  0x9E3779B9U
+#define EXT4_DX_MD4_K2     0x5A827999U
+#define EXT4_DX_MD4_K3     0x6ED9EBA1U
+
+// The hash value 0xFFFFFFFE is reserved as an end-of-directory marker
+#define EXT4_DX_HASH_EOF  0xFFFFFFFEU
+
+/**
+   A level of the hash tree that's being walked.
+**/
+typedef struct {
+  CHAR8            *Block;
+  EXT4_DX_ENTRY    *Entries;
+  EXT4_DX_ENTRY    *At;
+  UINT16           Count;
+} EXT4_DX_FRAME;
+
+/**
+   Retrieves a character of a name, as a signed or unsigned char, like the
+   platform-dependent char of the filesystem creator.
+
+   @param[in]      Name          Pointer to the name.
+   @param[in]      Index         Index of the character.
+   @param[in]      Unsigned      TRUE if the filesystem uses unsigned hashes.
+
+   @return The character, promoted to an INT32.
+**/
+STATIC
+INT32
+Ext4DxHashChar (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Index,
+  IN BOOLEAN      Unsigned
+  )
+{
+  return Unsigned ? (INT32)(UINT8)Name[Index] : (INT32)(INT8)Name[Index];
+}
+
+/**
+   Computes the legacy hash of a name.
+
+   @param[in]      Name          Pointer to the name.
+   @param[in]      Length        Length of the name.
+   @param[in]      Unsigned      TRUE if the filesystem uses unsigned hashes.
+
+   @return The hash.
+**/
+STATIC
+UINT32
+Ext4DxHackHash (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Hash;
+  UINT32  Hash0;
+  UINT32  Hash1;
+  UINTN   Index;
+
+  Hash0 = 0x12A3FE2D;
+  Hash1 = 0x37ABE8F9;
+
+  for (Index = 0; Index < Length; Index++) {
+    Hash = Hash1 + (Hash0 ^ (UINT32)(Ext4DxHashChar (Name, Index, Unsigned) * 7152373));
+
+    if ((Hash & BIT31) != 0) {
+      Hash -= 0x7FFFFFFF;
+    }
+
+    Hash1 = Hash0;
+    Hash0 = Hash;
+  }
+
+  return Hash0 << 1;
+}
+
+/**
+   Packs (part of) a name into an array of 32-bit words, padding it with its length.
+
+   @param[in]      Name          Pointer to the rest of the name.
+   @param[in]      Length        Remaining length of the name.
+   @param[out]     Buffer        Pointer to the destination words.
+   @param[in]      NumberWords   Number of words to fill.
+   @param[in]      Unsigned      TRUE if the filesystem uses unsigned hashes.
+**/
+STATIC
+VOID
+Ext4DxStrToHashBuf (
+  IN CONST CHAR8  *Name,
+  IN INTN         Length,
+  OUT UINT32      *Buffer,
+  IN INTN         NumberWords,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Pad;
+  UINT32  Value;
+  INTN    Index;
+
+  Pad  = (UINT32)Length | ((UINT32)Length << 8);
+  Pad |= Pad << 16;
+
+  Value = Pad;
+
+  if (Length > NumberWords * 4) {
+    Length = NumberWords * 4;
+  }
+
+  for (Index = 0; Index < Length; Index++) {
+    Value = (UINT32)Ext4DxHashChar (Name, Index, Unsigned) + (Value << 8);
+
+    if ((Index % 4) == 3) {
+      *Buffer++ = Value;
+      Value     = Pad;
+      NumberWords--;
+    }
+  }
+
+  if (--NumberWords >= 0) {
+    *Buffer++ = Value;
+  }
+
+  while (--NumberWords >= 0) {
+    *Buffer++ = Pad;
+  }
+}
+
+/**
+   Mixes a block of input into the hash state using TEA.
+
+   @param[in out]  State         Hash state.
+   @param[in]      In            Four words of input.
+**/
+STATIC
+VOID
+Ext4DxTeaTransform (
+  IN OUT UINT32    State[4],
+  IN CONST UINT32  In[4]
+  )
+{
+  UINT32  Sum;
+  UINT32  B0;
+  UINT32  B1;
+  UINTN   Round;
+
+  Sum = 0;
+  B0  = State[0];
+  B1  = State[1];
+
+  for (Round = 0; Round < 16; Round++) {
+    Sum += EXT4_DX_TEA_DELTA;
+    B0  += ((B1 << 4) + In[0]) ^ (B1 + Sum) ^ ((B1 >> 5) + In[1]);
+    B1  += ((B0 << 4) + In[2]) ^ (B0 + Sum) ^ ((B0 >> 5) + In[3]);
+  }
+
+  State[0] += B0;
+  State[1] += B1;
+}
+
+#define EXT4_MD4_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define EXT4_MD4_G(x, y, z)  (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define EXT4_MD4_H(x, y, z)  ((x) ^ (y) ^ (z))
+
+#define EXT4_MD4_ROUND(f, a, b, c, d, x, s)                                    \
+  do {                                                                         \
+    (a) += f ((b), (c), (d)) + (x);                                            \
+    (a)  = LRotU32 ((a), (s));                                                 \
+  } while (FALSE)
+
+/**
+   Mixes a block of input into the hash state using half of the MD4 rounds.
+
+   @param[in out]  State         Hash state.
+   @param[in]      In            Eight words of input.
+**/
+STATIC
+VOID
+Ext4DxHalfMd4Transform (
+  IN OUT UINT32    State[4],
+  IN CONST UINT32  In[8]
+  )
+{
+  UINT32  A;
+  UINT32  B;
+  UINT32  C;
+  UINT32  D;
+
+  A = State[0];
+  B = State[1];
+  C = State[2];
+  D = State[3];
+
+  // Round 1
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[0], 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[1], 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[2], 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[3], 19);
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[4], 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[5], 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[6], 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[7], 19);
+
+  // Round 2
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[1] + EXT4_DX_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[3] + EXT4_DX_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[5] + EXT4_DX_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[7] + EXT4_DX_MD4_K2, 13);
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[0] + EXT4_DX_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[2] + EXT4_DX_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[4] + EXT4_DX_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[6] + EXT4_DX_MD4_K2, 13);
+
+  // Round 3
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[3] + EXT4_DX_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[7] + EXT4_DX_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[2] + EXT4_DX_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[6] + EXT4_DX_MD4_K3, 15);
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[1] + EXT4_DX_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[5] + EXT4_DX_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[0] + EXT4_DX_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[4] + EXT4_DX_MD4_K3, 15);
+
+  State[0] += A;
+  State[1] += B;
+  State[2] += C;
+  State[3] += D;
+}
+
+/**
+   Computes the hash tree hash of a directory entry name.
+
+   @param[in]      Partition     Pointer to the ext4 partition.
+   @param[in]      Name          Pointer to the name, as stored on disk.
+   @param[in]      Length        Length of the name.
+   @param[in]      HashVersion   Hash algorithm (EXT4_DX_HASH_*).
+   @param[out]     Hash          Pointer to the resulting (major) hash.
+
+   @retval EFI_SUCCESS        The hash was computed.
+   @retval EFI_UNSUPPORTED    The hash algorithm isn't supported.
+**/
+STATIC
+EFI_STATUS
+Ext4DxHash (
+  IN  CONST EXT4_PARTITION  *Partition,
+  IN  CONST CHAR8           *Name,
+  IN  UINTN                 Length,
+  IN  UINT8                 HashVersion,
+  OUT UINT32                *Hash
+  )
+{
+  UINT32   State[4];
+  UINT32   In[8];
+  UINT32   Result;
+  INTN     Remaining;
+  BOOLEAN  Unsigned;
+  UINTN    Index;
+
+  // Default seed, used if the superblock's seed is all zeroes
+  State[0] = 0x67452301;
+  State[1] = 0xEFCDAB89;
+  State[2] = 0x98BADCFE;
+  State[3] = 0x10325476;
+
+  for (Index = 0; Index < ARRAY_SIZE (Partition->SuperBlock.s_hash_seed); Index++) {
+    if (Partition->SuperBlock.s_hash_seed[Index] != 0) {
+      CopyMem (State, Partition->SuperBlock.s_hash_seed, sizeof (State));
+      break;
+    }
+  }
+
+  Remaining = (INTN)Length;
+
+  switch (HashVersion) {
+    case EXT4_DX_HASH_LEGACY:
+    case EXT4_DX_HASH_LEGACY_UNSIGNED:
+      Result = Ext4DxHackHash (Name, Length, HashVersion == EXT4_DX_HASH_LEGACY_UNSIGNED);
+      break;
+    case EXT4_DX_HASH_HALF_MD4:
+    case EXT4_DX_HASH_HALF_MD4_UNSIGNED:
+      Unsigned = HashVersion == EXT4_DX_HASH_HALF_MD4_UNSIGNED;
+
+      while (Remaining > 0) {
+        Ext4DxStrToHashBuf (Name, Remaining, In, 8, Unsigned);
+        Ext4DxHalfMd4Transform (State, In);
+        Remaining -= 32;
+        Name      += 32;
+      }
+
+      Result = State[1];
+      break;
+    case EXT4_DX_HASH_TEA:
+    case EXT4_DX_HASH_TEA_UNSIGNED:
+      Unsigned = HashVersion == EXT4_DX_HASH_TEA_UNSIGNED;
+
+      while (Remaining > 0) {
+        Ext4DxStrToHashBuf (Name, Remaining, In, 4, Unsigned);
+        Ext4DxTeaTransform (State, In);
+        Remaining -= 16;
+        Name      += 16;
+      }
+
+      Result = State[0];
+      break;
+    default:
+      // SipHash is only used by casefolded directories, which we don't support.
+      return EFI_UNSUPPORTED;
+  }
+
+  Result &= ~1U;
+
+  if (Result == EXT4_DX_HASH_EOF) {
+    Result = EXT4_DX_HASH_EOF - 2;
+  }
+
+  *Hash = Result;
+  return EFI_SUCCESS;
+}
+
+/**
+   Checks if the checksum of a hash tree node is correct.
+
+   @param[in]      Partition     Pointer to the ext4 partition.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[in]      Block         Pointer to the node's block.
+   @param[in]      CountOffset   Offset of the EXT4_DX_COUNT_LIMIT inside the block.
+   @param[in]      CountLimit    Pointer to the node's EXT4_DX_COUNT_LIMIT.
+
+   @return TRUE if the checksum is correct, FALSE if there is corruption.
+**/
+STATIC
+BOOLEAN
+Ext4DxCheckChecksum (
+  IN CONST EXT4_PARTITION       *Partition,
+  IN CONST EXT4_FILE            *Directory,
+  IN CONST CHAR8                *Block,
+  IN UINTN                      CountOffset,
+  IN CONST EXT4_DX_COUNT_LIMIT  *CountLimit
+  )
+{
+  CONST EXT4_DX_TAIL  *Tail;
+  UINT32              Csum;
+  UINT32              Dummy;
+
+  if (!EXT4_HAS_METADATA_CSUM (Partition)) {
+    return TRUE;
+  }
+
+  Dummy = 0;
+  Tail  = (CONST EXT4_DX_TAIL *)(Block + CountOffset + CountLimit->limit * sizeof (EXT4_DX_ENTRY));
+
+  Csum = Ext4CalculateChecksum (Partition, &Directory->InodeNum, sizeof (EXT4_INO_NR), Partition->InitialSeed);
+  Csum = Ext4CalculateChecksum (Partition, &Directory->Inode->i_generation, sizeof (Directory->Inode->i_generation), Csum);
+  Csum = Ext4CalculateChecksum (Partition, Block, CountOffset + CountLimit->count * sizeof (EXT4_DX_ENTRY), Csum);
+  Csum = Ext4CalculateChecksum (Partition, &Tail->dt_reserved, sizeof (Tail->dt_reserved), Csum);
+  Csum = Ext4CalculateChecksum (Partition, &Dummy, sizeof (Dummy), Csum);
+
+  return Tail->dt_checksum == Csum;
+}
+
+/**
+   Validates a hash tree node and sets up its frame.
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Frame          Pointer to the frame, whose Block has already been read.
+   @param[in]      EntriesOffset  Offset of the node's EXT4_DX_ENTRY array inside the block.
+
+   @retval EFI_SUCCESS            The node is valid.
+   @retval EFI_VOLUME_CORRUPTED   The node is corrupted.
+**/
+STATIC
+EFI_STATUS
+Ext4DxSetupFrame (
+  IN     CONST EXT4_PARTITION  *Partition,
+  IN     CONST EXT4_FILE       *Directory,
+  IN OUT EXT4_DX_FRAME         *Frame,
+  IN     UINTN                 EntriesOffset
+  )
+{
+  EXT4_DX_COUNT_LIMIT  *CountLimit;
+  UINTN                Limit;
+
+  Limit = Partition->BlockSize - EntriesOffset;
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Limit -= sizeof (EXT4_DX_TAIL);
+  }
+
+  Limit /= sizeof (EXT4_DX_ENTRY);
+
+  CountLimit = (EXT4_DX_COUNT_LIMIT *)(Frame->Block + EntriesOffset);
+
+  if ((CountLimit->limit != Limit) || (CountLimit->count == 0) || (CountLimit->count > CountLimit->limit)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "[ext4] Invalid hash tree node count %u limit %u (expected %u)\n",
+      CountLimit->count,
+      CountLimit->limit,
+      Limit
+      ));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (!Ext4DxCheckChecksum (Partition, Directory, Frame->Block, EntriesOffset, CountLimit)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Invalid hash tree node checksum\n"));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Frame->Entries = (EXT4_DX_ENTRY *)CountLimit;
+  Frame->Count   = CountLimit->count;
+  Frame->At      = Frame->Entries;
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads and validates an interior (non-root) hash tree node.
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Frame          Pointer to the frame, with an allocated Block.
+   @param[in]      LogicalBlock   Logical block of the node.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4DxReadNode (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT EXT4_DX_FRAME   *Frame,
+  IN     EXT4_BLOCK_NR   LogicalBlock
+  )
+{
+  EFI_STATUS      Status;
+  EXT4_DIR_ENTRY  *FakeEntry;
+
+  Status = Ext4ReadDirBlock (Partition, Directory, Frame->Block, LogicalBlock);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Interior nodes start with an empty directory entry that covers the whole block,
+  // so that they look like empty blocks to older implementations.
+  FakeEntry = (EXT4_DIR_ENTRY *)Frame->Block;
+
+  if ((FakeEntry->inode != 0) || (FakeEntry->name_len != 0)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  return Ext4DxSetupFrame (Partition, Directory, Frame, EXT4_MIN_DIR_ENTRY_LEN);
+}
+
+/**
+   Finds the entry covering Hash in the frame's node, using binary search.
+
+   @param[in out]  Frame          Pointer to the frame.
+   @param[in]      Hash           Hash we're looking for.
+**/
+STATIC
+VOID
+Ext4DxSearchFrame (
+  IN OUT EXT4_DX_FRAME  *Frame,
+  IN     UINT32         Hash
+  )
+{
+  EXT4_DX_ENTRY  *l;
+  EXT4_DX_ENTRY  *r;
+  EXT4_DX_ENTRY  *m;
+
+  // The first entry has no hash (it holds the count and limit) and covers
+  // everything below the second entry's hash.
+  l = Frame->Entries + 1;
+  r = Frame->Entries + Frame->Count - 1;
+
+  while (l <= r) {
+    m = l + (r - l) / 2;
+
+    if (m->hash > Hash) {
+      r = m - 1;
+    } else {
+      l = m + 1;
+    }
+  }
+
+  Frame->At = l - 1;
+}
+
+/**
+   Advances to the next leaf block, if it may hold entries with the same hash
+   (hash collisions can spill over to the next leaf).
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Frames         Pointer to the array of frames.
+   @param[in]      Levels         Number of indirect levels of the tree.
+   @param[in]      Hash           Hash we're looking for.
+
+   @retval EFI_SUCCESS            The bottom frame now points to the next leaf.
+   @retval EFI_NOT_FOUND          There's no other leaf that can hold the hash.
+   @retval !EFI_SUCCESS           Failure reading the tree.
+**/
+STATIC
+EFI_STATUS
+Ext4DxNextLeaf (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT EXT4_DX_FRAME   *Frames,
+  IN     UINTN           Levels,
+  IN     UINT32          Hash
+  )
+{
+  UINTN          Level;
+  EXT4_DX_FRAME  *Frame;
+  EFI_STATUS     Status;
+
+  Level = Levels;
+
+  while (TRUE) {
+    Frame = &Frames[Level];
+    Frame->At++;
+
+    if (Frame->At < Frame->Entries + Frame->Count) {
+      break;
+    }
+
+    if (Level == 0) {
+      return EFI_NOT_FOUND;
+    }
+
+    Level--;
+  }
+
+  if ((Frame->At->hash & ~1U) != Hash) {
+    return EFI_NOT_FOUND;
+  }
+
+  // Reload the nodes below the one we advanced on
+  while (Level < Levels) {
+    Status = Ext4DxReadNode (Partition, Directory, &Frames[Level + 1], Frames[Level].At->block & EXT4_DX_BLOCK_MASK);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Level++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Retrieves a directory entry using the directory's hash tree.
+
+   @param[in]      Directory   Pointer to the opened (indexed) directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         The entry isn't indexed under its name's hash.
+   @retval EFI_VOLUME_CORRUPTED  The hash tree is corrupted.
+   @retval EFI_UNSUPPORTED       The hash tree uses an unsupported hash.
+   @retval !EFI_SUCCESS          Other failure.
+**/
+EFI_STATUS
+Ext4HashTreeRetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS         Status;
+  CHAR8              *Utf8Name;
+  UINTN              NameLength;
+  EXT4_DX_FRAME      Frames[EXT4_DX_MAX_LEVELS];
+  CHAR8              *Leaf;
+  EXT4_DIR_ENTRY     *Dot;
+  EXT4_DIR_ENTRY     *DotDot;
+  EXT4_DX_ROOT_INFO  *RootInfo;
+  UINT8              HashVersion;
+  UINTN              Levels;
+  UINTN              MaxLevels;
+  UINTN              Level;
+  UINT32             Hash;
+  UINT64             DirBlocks;
+  EXT4_BLOCK_NR      Block;
+
+  Leaf     = NULL;
+  Utf8Name = NULL;
+  ZeroMem (Frames, sizeof (Frames));
+
+  DirBlocks = DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Name, &Utf8Name);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  NameLength = AsciiStrLen (Utf8Name);
+
+  if (NameLength > EXT4_NAME_MAX) {
+    Status = EFI_NOT_FOUND;
+    goto Out;
+  }
+
+  Frames[0].Block = AllocatePool (Partition->BlockSize);
+  Leaf            = AllocatePool (Partition->BlockSize);
+
+  if ((Frames[0].Block == NULL) || (Leaf == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Out;
+  }
+
+  Status = Ext4ReadDirBlock (Partition, Directory, Frames[0].Block, 0);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Dot      = (EXT4_DIR_ENTRY *)Frames[0].Block;
+  DotDot   = (EXT4_DIR_ENTRY *)(Frames[0].Block + EXT4_DX_DOT_ENTRY_LEN);
+  RootInfo = (EXT4_DX_ROOT_INFO *)(Frames[0].Block + EXT4_DX_ROOT_INFO_OFFSET);
+
+  if ((Dot->rec_len != EXT4_DX_DOT_ENTRY_LEN) || (Dot->name_len != 1) || (Dot->name[0] != '.') ||
+      (DotDot->rec_len != Partition->BlockSize - EXT4_DX_DOT_ENTRY_LEN) || (DotDot->name_len != 2) ||
+      (RootInfo->reserved_zero != 0) || (RootInfo->info_length != EXT4_DX_ROOT_INFO_LENGTH))
+  {
+    DEBUG ((DEBUG_ERROR, "[ext4] Invalid hash tree root in inode %u\n", Directory->InodeNum));
+    Status = EFI_VOLUME_CORRUPTED;
+    goto Out;
+  }
+
+  MaxLevels = EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_LARGEDIR) ?
+              EXT4_DX_MAX_LEVELS : EXT4_DX_MAX_LEVELS_COMPAT;
+  Levels = RootInfo->indirect_levels;
+
+  if (Levels >= MaxLevels) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Hash tree of inode %u is too deep (%u)\n", Directory->InodeNum, (UINT32)Levels));
+    Status = EFI_VOLUME_CORRUPTED;
+    goto Out;
+  }
+
+  HashVersion = RootInfo->hash_version;
+
+  // The signedness of the legacy hashes depends on the char type of the machine that
+  // created the filesystem, which is recorded in the superblock.
+  if ((HashVersion <= EXT4_DX_HASH_TEA) &&
+      ((Partition->SuperBlock.s_flags & EXT4_FLAGS_UNSIGNED_HASH) != 0))
+  {
+    HashVersion += EXT4_DX_HASH_LEGACY_UNSIGNED;
+  }
+
+  Status = Ext4DxHash (Partition, Utf8Name, NameLength, HashVersion, &Hash);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Status = Ext4DxSetupFrame (Partition, Directory, &Frames[0], EXT4_DX_ROOT_INFO_OFFSET + RootInfo->info_length);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  for (Level = 0; ; Level++) {
+    Ext4DxSearchFrame (&Frames[Level], Hash);
+
+    Block = Frames[Level].At->block & EXT4_DX_BLOCK_MASK;
+
+    if (Block >= DirBlocks) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Out;
+    }
+
+    if (Level == Levels) {
+      break;
+    }
+
+    Frames[Level + 1].Block = AllocatePool (Partition->BlockSize);
+
+    if (Frames[Level + 1].Block == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Out;
+    }
+
+    Status = Ext4DxReadNode (Partition, Directory, &Frames[Level + 1], Block);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+  }
+
+  while (TRUE) {
+    Block = Frames[Levels].At->block & EXT4_DX_BLOCK_MASK;
+
+    if (Block >= DirBlocks) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Out;
+    }
+
+    Status = Ext4ReadDirBlock (Partition, Directory, Leaf, Block);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4SearchDirBlock (Partition, Leaf, Name, Result);
+
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
+    }
+
+    Status = Ext4DxNextLeaf (Partition, Directory, Frames, Levels, Hash);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+  }
+
+Out:
+  for (Level = 0; Level < ARRAY_SIZE (Frames); Level++) {
+    if (Frames[Level].Block != NULL) {
+      FreePool (Frames[Level].Block);
+    }
+  }
+
+  if (Leaf != NULL) {
+    FreePool (Leaf);
+  }
+
+  FreePool (Utf8Name);
+
+  return Status;
+}
@@ -70,60 +70,65 @@ Ext4CalculateInodeChecksum (
 }
 
 /**
-   Reads from an EXT4 inode.
+   Retrieves the physical block at which an extent starts.
+
+   @param[in]      Extent        Pointer to the extent.
+
+   @return The extent's first physical block.
+**/
+STATIC
+EXT4_BLOCK_NR
+Ext4ExtentPhysicalStart (
+  IN CONST EXT4_EXTENT  *Extent
+  )
+{
+  return LShiftU64 (Extent->ee_start_hi, 32) | Extent->ee_start_lo;
+}
+
+/**
+   Reads from an EXT4 inode, straight from the disk.
+   Physically contiguous extents are merged into a single disk read.
+
    @param[in]      Partition     Pointer to the opened EXT4 partition.
    @param[in]      File          Pointer to the opened file.
    @param[out]     Buffer        Pointer to the buffer.
    @param[in]      Offset        Offset of the read.
-   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
-                                 After a successful read, it's updated to the number of read bytes.
+   @param[in]      Length        Length of the read, in bytes. The caller must
+                                 ensure that [Offset, Offset + Length) is inside the file.
 
    @return Status of the read operation.
 **/
+STATIC
 EFI_STATUS
-Ext4Read (
+Ext4ReadUncached (
   IN     EXT4_PARTITION  *Partition,
   IN     EXT4_FILE       *File,
   OUT    VOID            *Buffer,
   IN     UINT64          Offset,
-  IN OUT UINTN           *Length
+  IN     UINTN           Length
   )
 {
-  EXT4_INODE   *Inode;
-  UINT64       InodeSize;
-  UINT64       CurrentSeek;
-  UINTN        RemainingRead;
-  UINTN        BeenRead;
-  UINTN        WasRead;
-  EXT4_EXTENT  Extent;
-  UINT32       BlockOff;
-  EFI_STATUS   Status;
-  BOOLEAN      HasBackingExtent;
-  UINT32       HoleOff;
-  UINT64       HoleLen;
-  UINT64       ExtentStartBytes;
-  UINT64       ExtentLengthBytes;
-  UINT64       ExtentLogicalBytes;
+  UINT64         CurrentSeek;
+  UINTN          RemainingRead;
+  UINTN          WasRead;
+  EXT4_EXTENT    Extent;
+  EXT4_EXTENT    NextExtent;
+  EXT4_BLOCK_NR  NextLogicalBlock;
+  UINT32         BlockOff;
+  EFI_STATUS     Status;
+  BOOLEAN        HasBackingExtent;
+  UINT32         HoleOff;
+  UINT64         HoleLen;
+  UINT64         ExtentStartBytes;
+  UINT64         ExtentLengthBytes;
+  UINT64         ExtentLogicalBytes;
 
   // Our extent offset is the difference between CurrentSeek and ExtentLogicalBytes
   UINT64  ExtentOffset;
-  UINTN   ExtentMayRead;
+  UINT64  ExtentMayRead;
 
-  Inode         = File->Inode;
-  InodeSize     = EXT4_INODE_SIZE (Inode);
   CurrentSeek   = Offset;
-  RemainingRead = *Length;
-  BeenRead      = 0;
-
-  DEBUG ((DEBUG_FS, "[ext4] Ext4Read(%s, Offset %lu, Length %lu)\n", File->Dentry->Name, Offset, *Length));
-
-  if (Offset > InodeSize) {
-    return EFI_DEVICE_ERROR;
-  }
-
-  if (RemainingRead > InodeSize - Offset) {
-    RemainingRead = (UINTN)(InodeSize - Offset);
-  }
+  RemainingRead = Length;
 
   while (RemainingRead != 0) {
     WasRead = 0;
@@ -160,17 +165,41 @@ Ext4Read (
       // size and memset all that
       ZeroMem (Buffer, WasRead);
     } else {
-      ExtentStartBytes = MultU64x32 (
-                           LShiftU64 (Extent.ee_start_hi, 32) |
-                           Extent.ee_start_lo,
-                           Partition->BlockSize
-                           );
-      ExtentLengthBytes  = Extent.ee_len * Partition->BlockSize;
+      ExtentStartBytes   = EXT4_BLOCK_TO_BYTES (Partition, Ext4ExtentPhysicalStart (&Extent));
+      ExtentLengthBytes  = MultU64x32 (Ext4GetExtentLength (&Extent), Partition->BlockSize);
       ExtentLogicalBytes = MultU64x32 ((UINT64)Extent.ee_block, Partition->BlockSize);
       ExtentOffset       = CurrentSeek - ExtentLogicalBytes;
-      ExtentMayRead      = (UINTN)(ExtentLengthBytes - ExtentOffset);
+      ExtentMayRead      = ExtentLengthBytes - ExtentOffset;
+
+      // Files are usually laid out in a few large runs of blocks, split in multiple extents
+      // due to the extent length limit. Merge the following extents as long as they're
+      // physically contiguous, so we issue a single disk read instead of one per extent.
+      while (ExtentMayRead < RemainingRead) {
+        NextLogicalBlock = (EXT4_BLOCK_NR)Extent.ee_block + Ext4GetExtentLength (&Extent);
+
+        Status = Ext4GetExtent (Partition, File, NextLogicalBlock, &NextExtent);
+
+        if (Status == EFI_NO_MAPPING) {
+          break;
+        }
+
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        if (EXT4_EXTENT_IS_UNINITIALIZED (&NextExtent) ||
+            (NextExtent.ee_block != NextLogicalBlock) ||
+            (Ext4ExtentPhysicalStart (&NextExtent) !=
+             Ext4ExtentPhysicalStart (&Extent) + Ext4GetExtentLength (&Extent)))
+        {
+          break;
+        }
+
+        ExtentMayRead += MultU64x32 (Ext4GetExtentLength (&NextExtent), Partition->BlockSize);
+        CopyMem (&Extent, &NextExtent, sizeof (EXT4_EXTENT));
+      }
 
-      WasRead = ExtentMayRead > RemainingRead ? RemainingRead : ExtentMayRead;
+      WasRead = ExtentMayRead > RemainingRead ? RemainingRead : (UINTN)ExtentMayRead;
 
       Status = Ext4ReadDiskIo (Partition, Buffer, WasRead, ExtentStartBytes + ExtentOffset);
 
@@ -188,12 +217,222 @@ Ext4Read (
 
     RemainingRead -= WasRead;
     Buffer         = (VOID *)((CHAR8 *)Buffer + WasRead);
-    BeenRead      += WasRead;
     CurrentSeek   += WasRead;
   }
 
-  *Length = BeenRead;
+  return EFI_SUCCESS;
+}
+
+/**
+   Copies as much of a read as possible out of the file's read-ahead buffer.
+
+   @param[in]      ReadAhead     Pointer to the file's read-ahead state.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in]      Length        Length of the read, in bytes.
+
+   @return Number of bytes copied, which may be 0.
+**/
+STATIC
+UINTN
+Ext4CopyFromReadAhead (
+  IN  CONST EXT4_READAHEAD  *ReadAhead,
+  OUT VOID                  *Buffer,
+  IN  UINT64                Offset,
+  IN  UINTN                 Length
+  )
+{
+  UINTN  BufferOffset;
+  UINTN  ToCopy;
+
+  if ((ReadAhead->Length == 0) || (Offset < ReadAhead->Start) ||
+      (Offset - ReadAhead->Start >= ReadAhead->Length))
+  {
+    return 0;
+  }
+
+  BufferOffset = (UINTN)(Offset - ReadAhead->Start);
+  ToCopy       = MIN (Length, ReadAhead->Length - BufferOffset);
+
+  CopyMem (Buffer, ReadAhead->Buffer + BufferOffset, ToCopy);
+  return ToCopy;
+}
+
+/**
+   Refills the file's read-ahead buffer, starting at Offset.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Offset        Offset of the read-ahead.
+   @param[in]      Length        Length of the read-ahead, in bytes. The caller must
+                                 ensure that [Offset, Offset + Length) is inside the file.
+
+   @return Status of the read operation.
+**/
+STATIC
+EFI_STATUS
+Ext4FillReadAhead (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN UINT64          Offset,
+  IN UINTN           Length
+  )
+{
+  EXT4_READAHEAD  *ReadAhead;
+  EFI_STATUS      Status;
+
+  ReadAhead         = &File->ReadAhead;
+  ReadAhead->Length = 0;
+
+  if (Length > ReadAhead->BufferSize) {
+    if (ReadAhead->Buffer != NULL) {
+      FreePool (ReadAhead->Buffer);
+    }
+
+    ReadAhead->BufferSize = 0;
+    ReadAhead->Buffer     = AllocatePool (Length);
+
+    if (ReadAhead->Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    ReadAhead->BufferSize = Length;
+  }
+
+  Status = Ext4ReadUncached (Partition, File, ReadAhead->Buffer, Offset, Length);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ReadAhead->Start  = Offset;
+  ReadAhead->Length = Length;
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the file's read-ahead buffer.
+
+   @param[in out]  File          Pointer to the opened file.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_FILE  *File
+  )
+{
+  if (File->ReadAhead.Buffer != NULL) {
+    FreePool (File->ReadAhead.Buffer);
+  }
+
+  ZeroMem (&File->ReadAhead, sizeof (EXT4_READAHEAD));
+}
+
+/**
+   Reads from an EXT4 inode.
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After a successful read, it's updated to the number of read bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4Read (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  OUT    VOID            *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  )
+{
+  EXT4_INODE      *Inode;
+  EXT4_READAHEAD  *ReadAhead;
+  UINT64          InodeSize;
+  UINT64          CurrentSeek;
+  UINTN           RemainingRead;
+  UINTN           ReadLength;
+  UINTN           WasRead;
+  UINTN           FillLength;
+  BOOLEAN         Sequential;
+  EFI_STATUS      Status;
+
+  Inode     = File->Inode;
+  ReadAhead = &File->ReadAhead;
+  InodeSize = EXT4_INODE_SIZE (Inode);
+
+  DEBUG ((DEBUG_FS, "[ext4] Ext4Read(%s, Offset %lu, Length %lu)\n", File->Dentry->Name, Offset, *Length));
+
+  if (Offset > InodeSize) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  RemainingRead = *Length;
+
+  if (RemainingRead > InodeSize - Offset) {
+    RemainingRead = (UINTN)(InodeSize - Offset);
+  }
+
+  ReadLength = RemainingRead;
+
+  // Loaders tend to read large files (kernels, initrds) in small chunks. Detect that and
+  // read ahead of them, doubling the window every time we need to refill it.
+  Sequential = Offset == ReadAhead->NextOffset;
+
+  if (!Sequential) {
+    ReadAhead->Window = 0;
+  }
+
+  ReadAhead->NextOffset = Offset + RemainingRead;
+
+  WasRead        = Ext4CopyFromReadAhead (ReadAhead, Buffer, Offset, RemainingRead);
+  RemainingRead -= WasRead;
+  Buffer         = (VOID *)((CHAR8 *)Buffer + WasRead);
+  CurrentSeek    = Offset + WasRead;
+
+  if (RemainingRead == 0) {
+    *Length = ReadLength;
+    return EFI_SUCCESS;
+  }
+
+  if (Sequential) {
+    ReadAhead->Window = ReadAhead->Window == 0 ? EXT4_READAHEAD_MIN_WINDOW :
+                        MIN (ReadAhead->Window * 2, EXT4_READAHEAD_MAX_WINDOW);
+  }
+
+  // Reads that are bigger than the window don't benefit from buffering.
+  if (Sequential && (RemainingRead < ReadAhead->Window)) {
+    FillLength = ReadAhead->Window;
+
+    if (FillLength > InodeSize - CurrentSeek) {
+      FillLength = (UINTN)(InodeSize - CurrentSeek);
+    }
+
+    Status = Ext4FillReadAhead (Partition, File, CurrentSeek, FillLength);
+
+    if (!EFI_ERROR (Status)) {
+      Ext4CopyFromReadAhead (ReadAhead, Buffer, CurrentSeek, RemainingRead);
+      *Length = ReadLength;
+      return EFI_SUCCESS;
+    }
+
+    if (Status != EFI_OUT_OF_RESOURCES) {
+      return Status;
+    }
+
+    // Out of memory, do a regular read instead.
+    ReadAhead->Window = 0;
+  }
+
+  Status = Ext4ReadUncached (Partition, File, Buffer, CurrentSeek, RemainingRead);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
+  *Length = ReadLength;
   return EFI_SUCCESS;
 }
 
@@ -36,14 +36,23 @@ Ext4OpenPartition (
   }
 
   InitializeListHead (&Part->OpenFiles);
+  InitializeListHead (&Part->DentryLru);
 
   Part->BlockIo = BlockIo;
   Part->DiskIo  = DiskIo;
   Part->DiskIo2 = DiskIo2;
 
+  Status = Ext4InitBlockCache (Part);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Part);
+    return Status;
+  }
+
   Status = Ext4OpenSuperblock (Part);
 
   if (EFI_ERROR (Status)) {
+    Ext4FreeBlockCache (Part);
     FreePool (Part);
     return Status;
   }
@@ -58,6 +67,7 @@ Ext4OpenPartition (
                                       );
 
   if (EFI_ERROR (Status)) {
+    Ext4FreeBlockCache (Part);
     FreePool (Part);
     return Status;
   }
@@ -119,13 +129,16 @@ Ext4UnmountAndFreePartition (
     Ext4CloseInternal (File);
   }
 
+  Ext4FlushDentryCache (Partition);
+
   DeletedRootDentry = Ext4UnrefDentry (Partition->RootDentry);
 
   if (!DeletedRootDentry) {
     DEBUG ((DEBUG_ERROR, "[ext4] Failed to delete root dentry - resource leak present.\n"));
   }
 
-  FreePool (Partition->BlockGroups);
+  Ext4FreeBlockCache (Partition);
+  Ext4FreeBlockGroups (Partition);
   FreePool (Partition);
 
   return EFI_SUCCESS;
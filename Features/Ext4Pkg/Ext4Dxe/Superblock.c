@@ -21,7 +21,7 @@ STATIC CONST UINT32  gSupportedIncompatFeat =
   EXT4_FEATURE_INCOMPAT_MMP | EXT4_FEATURE_INCOMPAT_RECOVER;
 
 // Future features that may be nice additions in the future:
-// 1) Btree support: Required for write support and would speed up lookups in large directories.
+// 1) Btree support: Required for write support (lookups in indexed directories are already supported).
 // 2) meta_bg: Required to mount meta_bg-enabled partitions.
 
 // Note: We ignore MMP because it's impossible that it's mapped elsewhere,
@@ -159,13 +159,9 @@ Ext4OpenSuperblock (
   OUT EXT4_PARTITION  *Partition
   )
 {
-  UINT32                 Index;
-  EFI_STATUS             Status;
-  EXT4_SUPERBLOCK        *Sb;
-  UINT32                 NrBlocksRem;
-  UINTN                  NrBlocks;
-  UINT32                 UnsupportedRoCompat;
-  EXT4_BLOCK_GROUP_DESC  *Desc;
+  EFI_STATUS       Status;
+  EXT4_SUPERBLOCK  *Sb;
+  UINT32           UnsupportedRoCompat;
 
   Status = Ext4ReadDiskIo (
              Partition,
@@ -260,8 +256,17 @@ Ext4OpenSuperblock (
     return EFI_UNSUPPORTED;
   }
 
-  Partition->NumberBlocks      = EXT4_BLOCK_NR_FROM_HALFS (Partition, Sb->s_blocks_count, Sb->s_blocks_count_hi);
-  Partition->NumberBlockGroups = DivU64x32 (Partition->NumberBlocks, Sb->s_blocks_per_group);
+  Partition->NumberBlocks = EXT4_BLOCK_NR_FROM_HALFS (Partition, Sb->s_blocks_count, Sb->s_blocks_count_hi);
+
+  if (Sb->s_first_data_block >= Partition->NumberBlocks) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  // The last block group may be partial, so round up
+  Partition->NumberBlockGroups = DivU64x32 (
+                                   Partition->NumberBlocks - Sb->s_first_data_block + Sb->s_blocks_per_group - 1,
+                                   Sb->s_blocks_per_group
+                                   );
 
   DEBUG ((
     DEBUG_FS,
@@ -287,36 +292,17 @@ Ext4OpenSuperblock (
     return EFI_VOLUME_CORRUPTED;
   }
 
-  NrBlocks = (UINTN)DivU64x32Remainder (
-                      MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize),
-                      Partition->BlockSize,
-                      &NrBlocksRem
-                      );
-
-  if (NrBlocksRem != 0) {
-    NrBlocks++;
-  }
-
-  Partition->BlockGroups = Ext4AllocAndReadBlocks (Partition, NrBlocks, Partition->BlockSize == 1024 ? 2 : 1);
+  Status = Ext4InitBlockGroups (Partition);
 
-  if (Partition->BlockGroups == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
-    Desc = Ext4GetBlockGroupDesc (Partition, Index);
-    if (!Ext4VerifyBlockGroupDescChecksum (Partition, Desc, Index)) {
-      DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %u has an invalid checksum\n", Index));
-      FreePool (Partition->BlockGroups);
-      return EFI_VOLUME_CORRUPTED;
-    }
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   // RootDentry will serve as the basis of our directory entry tree.
   Partition->RootDentry = Ext4CreateDentry (L"\\", NULL);
 
   if (Partition->RootDentry == NULL) {
-    FreePool (Partition->BlockGroups);
+    Ext4FreeBlockGroups (Partition);
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -325,7 +311,7 @@ Ext4OpenSuperblock (
 
   if (EFI_ERROR (Status)) {
     Ext4UnrefDentry (Partition->RootDentry);
-    FreePool (Partition->BlockGroups);
+    Ext4FreeBlockGroups (Partition);
   }
 
   return Status;
@@ -355,7 +341,7 @@ Ext4CalculateChecksum (
   switch (Partition->SuperBlock.s_checksum_type) {
     case EXT4_CHECKSUM_CRC32C:
       // For some reason, EXT4 really likes non-inverted CRC32C checksums, so we stick to that here.
-      return ~CalculateCrc32c(Buffer, Length, ~InitialValue);
+      return Ext4Crc32c (InitialValue, Buffer, Length);
     default:
       ASSERT (FALSE);
       return 0;
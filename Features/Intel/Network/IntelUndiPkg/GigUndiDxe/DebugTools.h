@@ -98,6 +98,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
     #define DEBUGWAIT(Lvl)
     #define DEBUGPRINTTIME(Lvl)
     #define DEBUGDUMP(Lvl, Msg)
+    #define DEBUGPRINTRXSTATS(Lvl, Stats)
 
 #elif defined (DBG_LVL) && DBG_LOG_ENABLED
     // Redirect all debug output to the UEFI Debug Log library.
@@ -279,6 +280,23 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
               DEBUGWAIT(Lvl)
 #endif /* End generic UNIMPLEMENTED */
 
+#if defined (DBG_LVL) && !defined (DEBUGPRINTRXSTATS)
+    /** Print the Rx throughput counters if a given debug level is set.
+
+       Stats must point to a structure with Packets, Bytes and TailWrites
+       counters. Bytes over time gives the Rx throughput, and Packets over
+       TailWrites shows how well Rx tail writes are being batched.
+
+       @param[in]   Lvl     Debug level
+       @param[in]   Stats   Pointer to the Rx statistics
+    **/
+    #define DEBUGPRINTRXSTATS(Lvl, Stats) \
+              DEBUGPRINT (Lvl, \
+                ("Rx packets: %ld, bytes: %ld, tail writes: %ld\n", \
+                 (Stats)->Packets, (Stats)->Bytes, (Stats)->TailWrites) \
+              )
+#endif /* End generic DEBUGPRINTRXSTATS */
+
 // STATIC_ASSERT macro borrowed from edk2 master branch.
 // Can be removed from driver once that macro gets integrated
 // into a edk2 release.
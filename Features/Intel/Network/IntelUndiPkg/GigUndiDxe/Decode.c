@@ -700,7 +700,7 @@ E1000UndiGetInitInfo (
   DbPtr                 = (PXE_DB_GET_INIT_INFO *) (UINTN) (CdbPtr->DBaddr);
 
   DbPtr->MemoryRequired = 0;
-  DbPtr->FrameDataLen   = PXE_MAX_TXRX_UNIT_ETHER;
+  DbPtr->FrameDataLen   = AdapterInfo->Mtu;
 
   // First check for FIBER, Links are 1000,0,0,0
   if (AdapterInfo->Hw.phy.media_type == e1000_media_type_copper ) {
@@ -721,10 +721,10 @@ E1000UndiGetInitInfo (
   DbPtr->HWaddrLen      = PXE_HWADDR_LEN_ETHER;
   DbPtr->MCastFilterCnt = MAX_MCAST_ADDRESS_CNT;
 
-  DbPtr->TxBufCnt       = DEFAULT_TX_DESCRIPTORS;
+  DbPtr->TxBufCnt       = AdapterInfo->TxDescriptorCount;
   DbPtr->TxBufSize      = sizeof (E1000_TRANSMIT_DESCRIPTOR);
-  DbPtr->RxBufCnt       = DEFAULT_RX_DESCRIPTORS;
-  DbPtr->RxBufSize      = sizeof (E1000_RECEIVE_DESCRIPTOR) + sizeof (LOCAL_RX_BUFFER);
+  DbPtr->RxBufCnt       = AdapterInfo->RxDescriptorCount;
+  DbPtr->RxBufSize      = sizeof (E1000_RECEIVE_DESCRIPTOR) + AdapterInfo->RxBufferSize;
 
   DbPtr->IFtype         = PXE_IFTYPE_ETHERNET;
   DbPtr->SupportedDuplexModes         = PXE_DUPLEX_ENABLE_FULL_SUPPORTED | PXE_DUPLEX_FORCE_FULL_SUPPORTED;
@@ -871,10 +871,10 @@ E1000UndiInitialize (
 
   // We allocate our own memory for transmit and receive so set MemoryUsed to 0.
   DbPtr->MemoryUsed = 0;
-  DbPtr->TxBufCnt   = DEFAULT_TX_DESCRIPTORS;
+  DbPtr->TxBufCnt   = AdapterInfo->TxDescriptorCount;
   DbPtr->TxBufSize  = sizeof (E1000_TRANSMIT_DESCRIPTOR);
-  DbPtr->RxBufCnt   = DEFAULT_RX_DESCRIPTORS;
-  DbPtr->RxBufSize  = sizeof (E1000_RECEIVE_DESCRIPTOR) + sizeof (LOCAL_RX_BUFFER);
+  DbPtr->RxBufCnt   = AdapterInfo->RxDescriptorCount;
+  DbPtr->RxBufSize  = sizeof (E1000_RECEIVE_DESCRIPTOR) + AdapterInfo->RxBufferSize;
 
   if (CdbPtr->StatCode != PXE_STATCODE_SUCCESS) {
     DEBUGPRINT (CRITICAL, ("E1000Inititialize failed! Statcode = %X\n", CdbPtr->StatCode));
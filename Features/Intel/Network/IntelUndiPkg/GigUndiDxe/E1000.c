@@ -1119,6 +1119,111 @@ E1000FirstTimeInit (
   return Status;
 }
 
+/** Gets the largest MTU the adapter can receive.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Largest supported MTU
+**/
+STATIC
+UINT16
+E1000GetMaxMtu (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82571_SUPPORT
+  case e1000_82571:
+  case e1000_82572:
+#ifndef NO_82574_SUPPORT
+  case e1000_82574:
+#endif /* !NO_82574_SUPPORT */
+#endif /* !NO_82571_SUPPORT */
+#ifndef NO_82575_SUPPORT
+  case e1000_82575:
+  case e1000_82576:
+#ifndef NO_82580_SUPPORT
+  case e1000_82580:
+#endif /* !NO_82580_SUPPORT */
+  case e1000_i350:
+  case e1000_i354:
+  case e1000_i210:
+  case e1000_i211:
+#endif /* !NO_82575_SUPPORT */
+    return MAX_JUMBO_FRAME_LENGTH - RX_FRAME_OVERHEAD;
+  default:
+    // No (or not validated) jumbo frame support
+    return PXE_MAX_TXRX_UNIT_ETHER;
+  }
+}
+
+/** Clamps a requested descriptor count to what the hardware supports.
+
+   @param[in]   Count   Requested number of descriptors
+
+   @return   Number of descriptors to use
+**/
+STATIC
+UINT16
+E1000ClampDescriptorCount (
+  IN UINT16 Count
+  )
+{
+  Count = MAX (Count, MIN_RING_DESCRIPTORS);
+  Count = MIN (Count, MAX_RING_DESCRIPTORS);
+
+  return (UINT16) (Count & ~(RING_DESCRIPTORS_ALIGN - 1));
+}
+
+/** Determines the Rx/Tx ring sizes, the MTU and the Rx buffer size.
+
+   Requested values come from PcdGigUndiRxDescriptorCount, PcdGigUndiTxDescriptorCount
+   and PcdGigUndiMtu, and are clamped to what the adapter supports.
+   Must be called after E1000FirstTimeInit, as limits depend on the MAC type.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Ring sizes, MTU and Rx buffer size set in AdapterInfo
+**/
+VOID
+E1000ConfigureRingSizes (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  UINT16 Mtu;
+  UINT16 MaxMtu;
+
+  AdapterInfo->RxDescriptorCount = E1000ClampDescriptorCount (PcdGet16 (PcdGigUndiRxDescriptorCount));
+  AdapterInfo->TxDescriptorCount = E1000ClampDescriptorCount (PcdGet16 (PcdGigUndiTxDescriptorCount));
+
+  Mtu    = MAX (PcdGet16 (PcdGigUndiMtu), PXE_MAX_TXRX_UNIT_ETHER);
+  MaxMtu = E1000GetMaxMtu (AdapterInfo);
+  if (Mtu > MaxMtu) {
+    DEBUGPRINT (INIT, ("MTU %d not supported, falling back to %d\n", Mtu, MaxMtu));
+    Mtu = MaxMtu;
+  }
+
+  AdapterInfo->Mtu = Mtu;
+
+  // The hardware takes Rx buffer sizes in powers of two, from 2K to 16K.
+  // Each buffer has to fit a whole frame.
+  AdapterInfo->RxBufferSize = RX_BUFFER_SIZE;
+  while (AdapterInfo->RxBufferSize < Mtu + RX_FRAME_OVERHEAD) {
+    AdapterInfo->RxBufferSize *= 2;
+  }
+
+  ASSERT (AdapterInfo->RxBufferSize <= MAX_RX_BUFFER_SIZE);
+
+  DEBUGPRINT (
+    INIT,
+    ("Rx descriptors: %d, Tx descriptors: %d, MTU: %d, Rx buffer size: %d\n",
+      AdapterInfo->RxDescriptorCount,
+      AdapterInfo->TxDescriptorCount,
+      AdapterInfo->Mtu,
+      AdapterInfo->RxBufferSize)
+    );
+}
+
 /** Initializes the gigabit adapter, setting up memory addresses, MAC Addresses,
    Type of card, etc.
 
@@ -63,6 +63,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Library/BaseLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
 
 #include <IndustryStandard/Pci.h>
 
@@ -523,18 +524,28 @@ typedef struct {
 typedef struct e1000_rx_desc E1000_RECEIVE_DESCRIPTOR;
 
 
-// TX Buffer size including crc and padding
+// Standard Rx buffer size including crc and padding
 #define RX_BUFFER_SIZE 2048
 
+// Largest Rx buffer size supported by the hardware
+#define MAX_RX_BUFFER_SIZE 16384
+
+// Ring sizes are taken from PcdGigUndiRxDescriptorCount and PcdGigUndiTxDescriptorCount.
+// These are only the package defaults.
 #define DEFAULT_RX_DESCRIPTORS 64
 #define DEFAULT_TX_DESCRIPTORS 8
 
-#pragma pack(1)
-typedef struct {
-  UINT8  RxBuffer[RX_BUFFER_SIZE - (sizeof (UINT64))];
-  UINT64 BufferUsed;
-} LOCAL_RX_BUFFER, *PLOCAL_RX_BUFFER;
-#pragma pack()
+// Descriptor ring length registers need 128 byte granularity,
+// so descriptor counts are kept a multiple of 8.
+#define MIN_RING_DESCRIPTORS   8
+#define MAX_RING_DESCRIPTORS   4096
+#define RING_DESCRIPTORS_ALIGN 8
+
+// Bytes an Rx buffer needs on top of the MTU: Ethernet header, VLAN tag and CRC
+#define RX_FRAME_OVERHEAD  (PXE_MAC_HEADER_LEN_ETHER + 4 + ETHERNET_FCS_SIZE)
+
+// Largest frame accepted by adapters with jumbo frame support
+#define MAX_JUMBO_FRAME_LENGTH 9216
 
 typedef struct e1000_tx_desc E1000_TRANSMIT_DESCRIPTOR;
 
@@ -621,6 +632,10 @@ typedef struct DRIVER_DATA_S {
 
   RECEIVE_RING            RxRing;
   TRANSMIT_RING           TxRing;
+  UINT16                  RxDescriptorCount;
+  UINT16                  TxDescriptorCount;
+  UINT16                  RxBufferSize;
+  UINT16                  Mtu; // max frame data length, without the media header
 
   BOOLEAN                 MacAddrOverride;
   BOOLEAN                 FlashWriteInProgress;
@@ -659,12 +674,6 @@ typedef struct UNDI_PRIVATE_DATA_S {
   UINT32                                    LastAttemptStatus;
 } UNDI_PRIVATE_DATA;
 
-typedef struct {
-  E1000_RECEIVE_DESCRIPTOR  RxRing[DEFAULT_RX_DESCRIPTORS];
-  E1000_TRANSMIT_DESCRIPTOR TxRing[DEFAULT_TX_DESCRIPTORS];
-  LOCAL_RX_BUFFER           RxBuffer[DEFAULT_RX_DESCRIPTORS];
-} GIG_UNDI_DMA_RESOURCES;
-
 typedef struct {
   UINT8                     Pf0:1;
   UINT8                     Pf1:1;
@@ -679,12 +688,6 @@ typedef union {
 
 #define BYTE_ALIGN_64    0x7F
 
-/* We need enough space to store TX descriptors, RX descriptors,
- RX buffers, and enough left over to do a 64 byte alignment. */
-#define RX_RING_SIZE    sizeof (((GIG_UNDI_DMA_RESOURCES*) 0)->RxRing)
-#define TX_RING_SIZE    sizeof (((GIG_UNDI_DMA_RESOURCES*) 0)->TxRing)
-#define RX_BUFFERS_SIZE sizeof (((GIG_UNDI_DMA_RESOURCES*) 0)->RxBuffer)
-
 #define FOUR_GIGABYTE (UINT64) 0x100000000
 
 /* If the surprise removal has been detected,
@@ -756,6 +759,21 @@ E1000FirstTimeInit (
   IN DRIVER_DATA *AdapterInfo
   );
 
+/** Determines the Rx/Tx ring sizes, the MTU and the Rx buffer size.
+
+   Requested values come from PcdGigUndiRxDescriptorCount, PcdGigUndiTxDescriptorCount
+   and PcdGigUndiMtu, and are clamped to what the adapter supports.
+   Must be called after E1000FirstTimeInit, as limits depend on the MAC type.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Ring sizes, MTU and Rx buffer size set in AdapterInfo
+**/
+VOID
+E1000ConfigureRingSizes (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
 #define MAX_QUEUE_ENABLE_TIME   200
 
 /** Starts the receive unit.
@@ -1292,10 +1292,12 @@ InitController (
   if (Status == EFI_ACCESS_DENIED) {
     UndiPrivateData->NicInfo.UndiEnabled = FALSE;
   } else {
+    E1000ConfigureRingSizes (&UndiPrivateData->NicInfo);
+
     // Initialize Tx & Rx queues
     Status = TransmitInitialize (
                &UndiPrivateData->NicInfo,
-               DEFAULT_TX_DESCRIPTORS
+               UndiPrivateData->NicInfo.TxDescriptorCount
                );
 
     if (EFI_ERROR (Status)) {
@@ -1305,8 +1307,8 @@ InitController (
 
     Status = ReceiveInitialize (
                &UndiPrivateData->NicInfo,
-               DEFAULT_RX_DESCRIPTORS,
-               RX_BUFFER_SIZE
+               UndiPrivateData->NicInfo.RxDescriptorCount,
+               UndiPrivateData->NicInfo.RxBufferSize
                );
 
     if (EFI_ERROR (Status)) {
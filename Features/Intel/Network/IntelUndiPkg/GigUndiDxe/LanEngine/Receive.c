@@ -533,7 +533,8 @@ ReceiveReset (
     return Status;
   }
 
-  RxRing->NextToUse = 0;
+  RxRing->NextToUse          = 0;
+  RxRing->PendingTailUpdates = 0;
 
   return EFI_SUCCESS;
 }
@@ -636,6 +637,7 @@ ReceiveGetPacket (
   UINT16              HeaderLength;
   UINT8               RxError;
   UINT16              LengthToCopy;
+  UINT16              CleanedDesc;
 
   if (AdapterInfo == NULL) {
     DEBUGPRINT (CRITICAL, ("Invalid input parameters.\n"));
@@ -721,6 +723,9 @@ ReceiveGetPacket (
     LengthToCopy
     );
 
+  RxRing->Statistics.Packets++;
+  RxRing->Statistics.Bytes += *PacketLength;
+
   Status = EFI_SUCCESS;
 
 ExitAdvanceDesc:
@@ -738,9 +743,8 @@ ExitAdvanceDesc:
     RECEIVE_BUFFER_PA (RxRing, RxRing->NextToUse)
     );
 
-  DEBUGPRINT (RX, ("Advancing Rx tail to %d\n", RxRing->NextToUse));
-
-  ReceiveUpdateTail (AdapterInfo, RxRing->NextToUse);
+  CleanedDesc = RxRing->NextToUse;
+  RxRing->PendingTailUpdates++;
 
   if (++RxRing->NextToUse == RxRing->BufferCount) {
     RxRing->NextToUse = 0;
@@ -748,6 +752,19 @@ ExitAdvanceDesc:
 
   DEBUGPRINT (RX, ("RxRing->NextToUse = %d\n", RxRing->NextToUse));
 
+  // Tail writes are MMIO, so return cleaned descriptors to HW in batches
+  // while more packets are already waiting in the ring. Once the ring is
+  // drained, give everything back right away so HW never runs dry.
+  if ((RxRing->PendingTailUpdates >= RECEIVE_TAIL_UPDATE_BATCH)
+    || !ReceiveIsDescriptorDone (RECEIVE_DESCRIPTOR_VA (RxRing, RxRing->NextToUse), NULL, NULL, NULL, NULL))
+  {
+    DEBUGPRINT (RX, ("Advancing Rx tail to %d\n", CleanedDesc));
+
+    ReceiveUpdateTail (AdapterInfo, CleanedDesc);
+    RxRing->PendingTailUpdates = 0;
+    RxRing->Statistics.TailWrites++;
+  }
+
 Exit:
   return Status;
 }
@@ -848,6 +865,7 @@ ReceiveStop (
 
   if (Status == EFI_SUCCESS) {
     DEBUGPRINT (RX, ("Rx ring is now stopped.\n"));
+    DEBUGPRINTRXSTATS (DIAG, &RxRing->Statistics);
     RxRing->IsRunning = FALSE;
   }
 
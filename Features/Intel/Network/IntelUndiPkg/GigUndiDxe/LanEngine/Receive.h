@@ -35,6 +35,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define RECEIVE_RING_SIGNATURE       0x80865278    /* Intel vendor + 'Rx' */
 
+/* Max number of cleaned Rx descriptors held back before the Rx tail is updated */
+#define RECEIVE_TAIL_UPDATE_BATCH    8
+
+typedef struct _RECEIVE_STATISTICS {
+  UINT64              Packets;
+  UINT64              Bytes;
+  UINT64              TailWrites;
+} RECEIVE_STATISTICS;
+
 typedef struct _RECEIVE_RING {
   UINT32              Signature;
   BOOLEAN             IsRunning;
@@ -43,6 +52,8 @@ typedef struct _RECEIVE_RING {
   UNDI_DMA_MAPPING    Descriptors;
   UNDI_DMA_MAPPING    Buffers;
   UINT16              NextToUse;
+  UINT16              PendingTailUpdates;   /* Cleaned descriptors not yet given back to HW */
+  RECEIVE_STATISTICS  Statistics;
 } RECEIVE_RING;
 
 /** Check whether Rx ring structure is in initialized state.
@@ -171,13 +171,47 @@ ReceiveConfigureQueue (
     E1000_WRITE_REG (
       &AdapterInfo->Hw,
       E1000_SRRCTL (0),
-      E1000_SRRCTL_DESCTYPE_LEGACY
+      E1000_SRRCTL_DESCTYPE_LEGACY | (RxRing->BufferSize >> E1000_SRRCTL_BSIZEPKT_SHIFT)
+      );
+
+    // Long packets are also limited by RLPML on these adapters
+    E1000_WRITE_REG (
+      &AdapterInfo->Hw,
+      E1000_RLPML,
+      AdapterInfo->Mtu + RX_FRAME_OVERHEAD
       );
   default:
     break;
   }
 #endif /* !NO_82575_SUPPORT */
 
+  // Program the Rx buffer size. Buffers bigger than 2K need the buffer size
+  // extension, and frames bigger than a standard one need long packet reception.
+  TempReg = E1000_READ_REG (&AdapterInfo->Hw, E1000_RCTL);
+  TempReg &= ~(E1000_RCTL_SZ_256 | E1000_RCTL_BSEX | E1000_RCTL_LPE);
+
+  switch (RxRing->BufferSize) {
+  case 4096:
+    TempReg |= E1000_RCTL_BSEX | E1000_RCTL_SZ_4096;
+    break;
+  case 8192:
+    TempReg |= E1000_RCTL_BSEX | E1000_RCTL_SZ_8192;
+    break;
+  case 16384:
+    TempReg |= E1000_RCTL_BSEX | E1000_RCTL_SZ_16384;
+    break;
+  default:
+    ASSERT (RxRing->BufferSize == RX_BUFFER_SIZE);
+    TempReg |= E1000_RCTL_SZ_2048;
+    break;
+  }
+
+  if (AdapterInfo->Mtu > PXE_MAX_TXRX_UNIT_ETHER) {
+    TempReg |= E1000_RCTL_LPE;
+  }
+
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RCTL, TempReg);
+
   E1000_WRITE_REG (&AdapterInfo->Hw, E1000_MRQC, 0);
 
 
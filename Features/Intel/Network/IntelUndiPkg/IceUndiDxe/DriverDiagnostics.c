@@ -110,6 +110,7 @@ _DisplayBuffersAndDescriptors (
   DEBUGDUMP (DIAG, ("Receive Descriptor\n"));
   DEBUGDUMP (DIAG, ("QRX_TAIL=%X ", rd32 (&AdapterInfo->Hw, QRX_TAIL (0))));
   DEBUGDUMP (DIAG, ("RxRing.NextToUse=%X\n", AdapterInfo->Vsi.RxRing.NextToUse));
+  DEBUGPRINTRXSTATS (DIAG, &AdapterInfo->Vsi.RxRing.TxRxQueues.RxStats);
 
   for (j = 0; j < AdapterInfo->Vsi.RxRing.Count; j++) {
     ReceiveDesc = ICE_RX_DESC (&AdapterInfo->Vsi.RxRing, j);
@@ -171,6 +171,7 @@ IceReceive (
   UINT8                    *PacketPtr;
   UINT16                    TempLen;
   UINT16                    i;
+  UINT16                    CleanedDesc;
 
   UINT32 RxStatus;
   UINT32 RxError;
@@ -294,6 +295,9 @@ IceReceive (
         (UINT64) (RxRing->UnmappedBuffers[RxRing->NextToUse]))
       );
 
+      RxRing->TxRxQueues.RxStats.Packets++;
+      RxRing->TxRxQueues.RxStats.Bytes += RxPacketLength;
+
       StatCode = PXE_STATCODE_SUCCESS;
     } else {
       DEBUGPRINT (CRITICAL, ("ERROR: RxPacketLength: %x, RxError: %x \n", RxPacketLength, RxError));
@@ -303,14 +307,29 @@ IceReceive (
     ReceiveDescriptor->wb.qword1.status_error_len = 0;
     ReceiveDescriptor->read.pkt_addr = (UINT64) RxRing->PhysicalBuffers[RxRing->NextToUse];
 
-    // Move the current cleaned buffer pointer, being careful to wrap it as needed.  Then update the hardware,
-    // so it knows that an additional buffer can be used.
-    IceWrite32 (AdapterInfo, QRX_TAIL (0), RxRing->NextToUse);
+    // Move the current cleaned buffer pointer, being careful to wrap it as needed.
+    CleanedDesc = RxRing->NextToUse;
+    RxRing->PendingTailUpdates++;
 
     RxRing->NextToUse++;
     if (RxRing->NextToUse == RxRing->Count) {
       RxRing->NextToUse = 0;
     }
+
+    // Then update the hardware, so it knows that additional buffers can be used.
+    // Tail writes are MMIO, so while more packets are already waiting in the ring
+    // the cleaned buffers are handed back in batches. Once the ring is drained,
+    // everything is given back right away so the HW never runs out of buffers.
+    DescQWord = ICE_RX_DESC (RxRing, RxRing->NextToUse)->wb.qword1.status_error_len;
+    RxStatus  = (UINT32) ((DescQWord & ICE_RXD_QW1_STATUS_M) >> ICE_RXD_QW1_STATUS_S);
+
+    if ((RxRing->PendingTailUpdates >= ICE_RX_TAIL_UPDATE_BATCH)
+      || ((RxStatus & (1 << ICE_RX_DESC_STATUS_DD_S)) == 0))
+    {
+      IceWrite32 (AdapterInfo, QRX_TAIL (0), CleanedDesc);
+      RxRing->PendingTailUpdates = 0;
+      RxRing->TxRxQueues.RxStats.TailWrites++;
+    }
   }
 
   return StatCode;
@@ -981,6 +1000,7 @@ IceReceiveStop (
     return ICE_ERR_NOT_READY;
   }
   DEBUGPRINT (INIT, ("Rx ring disabled\n"));
+  DEBUGPRINTRXSTATS (DIAG, &AdapterInfo->Vsi.RxRing.TxRxQueues.RxStats);
 
   gBS->Stall (50000);
 
@@ -1202,6 +1222,7 @@ IceConfigureRxQueues (
   IceWrite32 (AdapterInfo, QRX_TAIL (0), 0);
   IceWrite32 (AdapterInfo, QRX_TAIL (0), RxRing->Count - 1);
   AdapterInfo->Vsi.RxRing.NextToUse = 0;
+  AdapterInfo->Vsi.RxRing.PendingTailUpdates = 0;
 #if (DBG_LVL & RX)
   UINT32 QRxTail = IceRead32 (AdapterInfo, QRX_TAIL (0));
   DEBUGPRINT (INIT, ("QRXTail %d\n", QRxTail));
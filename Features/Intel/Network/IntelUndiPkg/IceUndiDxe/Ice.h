@@ -153,6 +153,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define ICE_NUM_TX_RX_DESCRIPTORS 16
 #endif /* RXTX_RING_SIZE */
 
+// Max number of cleaned Rx descriptors held back before the Rx tail is updated
+#define ICE_RX_TAIL_UPDATE_BATCH  (ICE_NUM_TX_RX_DESCRIPTORS / 4)
+
 // timeout for Tx/Rx queue enable/disable
 #define START_RINGS_TIMEOUT 100
 #define STOP_RINGS_TIMEOUT 1000
@@ -482,6 +485,7 @@ typedef struct {
   UINT64 NonEopDescs;
   UINT64 AllocRxPageFailed;
   UINT64 AllocRxBuffFailed;
+  UINT64 TailWrites;
 } ICE_RX_QUEUE_STATS;
 
 /* struct that defines a descriptor ring, associated with a VSI */
@@ -499,6 +503,9 @@ typedef struct {
   UINT16 NextToUse;
   UINT16 NextToClean;
 
+  /* Rx only: cleaned descriptors not yet given back to HW through the tail */
+  UINT16 PendingTailUpdates;
+
   UNDI_DMA_MAPPING    *TxBufferMappings;
 
   /* stats structs */
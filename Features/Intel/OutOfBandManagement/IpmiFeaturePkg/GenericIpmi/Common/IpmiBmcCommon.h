@@ -124,6 +124,30 @@ Returns:
 --*/
 ;
 
+EFI_STATUS
+UpdateErrorStatus (
+  IN UINT8                      BmcError,
+  IPMI_BMC_INSTANCE_DATA        *IpmiInstance
+  )
+/*++
+
+Routine Description:
+
+  Check if the completion code is a Soft Error and increment the count.  The count
+  is not updated if the BMC is in Force Update Mode.
+
+Arguments:
+
+  BmcError      - Completion code to check
+  IpmiInstance  - BMC instance data
+
+Returns:
+
+  EFI_SUCCESS   - Status
+
+--*/
+;
+
 
 EFI_STATUS
 EFIAPI
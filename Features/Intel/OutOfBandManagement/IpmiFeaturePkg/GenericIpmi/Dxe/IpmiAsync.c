@@ -0,0 +1,1053 @@
+/** @file
+  Asynchronous KCS transport and response cache for the Generic IPMI DXE driver.
+
+  Commands submitted through the asynchronous transport protocol are queued and
+  moved across the KCS interface by a periodic timer event, one status bit at a
+  time, instead of spinning in MicroSecondDelay() until the BMC responds.
+
+  @copyright
+  Copyright 2026 Intel Corporation. <BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "IpmiAsync.h"
+
+/******************************************************************************
+ * Local variables
+ */
+STATIC IPMI_BMC_INSTANCE_DATA     *mAsyncIpmiInstance = NULL;
+STATIC LIST_ENTRY                 mAsyncQueue = INITIALIZE_LIST_HEAD_VARIABLE (mAsyncQueue);
+STATIC KCS_ASYNC_TRANSFER         mAsyncTransfer;
+STATIC EFI_EVENT                  mAsyncTimerEvent = NULL;
+STATIC BOOLEAN                    mAsyncTimerRunning = FALSE;
+STATIC BOOLEAN                    mAsyncBusy = FALSE;
+STATIC IPMI_RESPONSE_CACHE_ENTRY  mResponseCache[IPMI_CACHE_ENTRIES];
+STATIC UINTN                      mResponseCacheNext = 0;
+
+BOOLEAN
+IpmiCacheGetKey (
+  IN  UINT8                     NetFunction,
+  IN  UINT8                     Command,
+  IN  UINT8                     *CommandData,
+  IN  UINT32                    CommandDataSize,
+  OUT UINT8                     *Key,
+  OUT UINT8                     *KeySize
+  )
+/*++
+
+Routine Description:
+
+  Check if the response to a command can be cached, and build its cache key
+  from the command data.
+
+Arguments:
+
+  NetFunction       - Net Function of the command
+  Command           - IPMI command
+  CommandData       - Pointer to command data buffer
+  CommandDataSize   - Size of command data buffer
+  Key               - Buffer of IPMI_CACHE_KEY_SIZE bytes that receives the key
+  KeySize           - Size of the key
+
+Returns:
+
+  TRUE  - The response can be cached
+  FALSE - The response must always come from the BMC
+
+--*/
+{
+  UINT32  KeyOffset;
+
+  KeyOffset = 0;
+
+  //
+  // Get Device ID is not cached: its UpdateMode bit changes when the BMC
+  // enters or leaves firmware update, and that is what callers poll it for.
+  //
+  if (NetFunction == IPMI_NETFN_STORAGE) {
+    switch (Command) {
+      case IPMI_STORAGE_GET_SDR_REPOSITORY_INFO:
+      case IPMI_STORAGE_GET_FRU_INVENTORY_AREAINFO:
+      case IPMI_STORAGE_READ_FRU_DATA:
+        break;
+
+      case IPMI_STORAGE_GET_SDR:
+        //
+        // Skip the reservation ID, it changes with every Reserve SDR Repository
+        // command but does not change the record that is returned.
+        //
+        KeyOffset = sizeof (UINT16);
+        break;
+
+      default:
+        return FALSE;
+    }
+  } else {
+    return FALSE;
+  }
+
+  if ((CommandDataSize < KeyOffset) ||
+      ((CommandDataSize - KeyOffset) > IPMI_CACHE_KEY_SIZE) ||
+      ((CommandDataSize > KeyOffset) && (CommandData == NULL))) {
+    return FALSE;
+  }
+
+  *KeySize = (UINT8) (CommandDataSize - KeyOffset);
+  if (*KeySize > 0) {
+    CopyMem (Key, CommandData + KeyOffset, *KeySize);
+  }
+
+  return TRUE;
+}
+
+BOOLEAN
+IpmiCacheInvalidatedBy (
+  IN UINT8                      NetFunction,
+  IN UINT8                      Command
+  )
+/*++
+
+Routine Description:
+
+  Check if a command changes the SDR repository or FRU data, or resets the BMC.
+
+Arguments:
+
+  NetFunction       - Net Function of the command
+  Command           - IPMI command
+
+Returns:
+
+  TRUE  - Cached responses may be stale once the command is sent
+  FALSE - The command does not affect cached responses
+
+--*/
+{
+  if (NetFunction == IPMI_NETFN_APP) {
+    return (BOOLEAN) ((Command == IPMI_APP_COLD_RESET) || (Command == IPMI_APP_WARM_RESET));
+  }
+
+  if (NetFunction == IPMI_NETFN_STORAGE) {
+    switch (Command) {
+      case IPMI_STORAGE_WRITE_FRU_DATA:
+      case IPMI_STORAGE_ADD_SDR:
+      case IPMI_STORAGE_PARTIAL_ADD_SDR:
+      case IPMI_STORAGE_DELETE_SDR:
+      case IPMI_STORAGE_CLEAR_SDR:
+      case IPMI_STORAGE_ENTER_SDR_UPDATE_MODE:
+      case IPMI_STORAGE_EXIT_SDR_UPDATE_MODE:
+      case IPMI_STORAGE_RUN_INIT_AGENT:
+        return TRUE;
+
+      default:
+        break;
+    }
+  }
+
+  return FALSE;
+}
+
+VOID
+IpmiCacheFlush (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Drop every cached response.
+
+Arguments:
+
+  None
+
+Returns:
+
+  VOID
+
+--*/
+{
+  ZeroMem (mResponseCache, sizeof (mResponseCache));
+  mResponseCacheNext = 0;
+}
+
+IPMI_RESPONSE_CACHE_ENTRY *
+IpmiCacheLookup (
+  IN UINT8                      NetFunction,
+  IN UINT8                      Command,
+  IN UINT8                      *CommandData,
+  IN UINT32                     CommandDataSize
+  )
+/*++
+
+Routine Description:
+
+  Find the cached response to a command.
+
+Arguments:
+
+  NetFunction       - Net Function of the command
+  Command           - IPMI command
+  CommandData       - Pointer to command data buffer
+  CommandDataSize   - Size of command data buffer
+
+Returns:
+
+  Pointer to the cache entry, or NULL if the response is not cached
+
+--*/
+{
+  UINT8   Key[IPMI_CACHE_KEY_SIZE];
+  UINT8   KeySize;
+  UINTN   Index;
+
+  if (!IpmiCacheGetKey (NetFunction, Command, CommandData, CommandDataSize, Key, &KeySize)) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < IPMI_CACHE_ENTRIES; Index++) {
+    if (mResponseCache[Index].Valid &&
+        (mResponseCache[Index].NetFunction == NetFunction) &&
+        (mResponseCache[Index].Command == Command) &&
+        (mResponseCache[Index].KeySize == KeySize) &&
+        (CompareMem (mResponseCache[Index].Key, Key, KeySize) == 0)) {
+      return &mResponseCache[Index];
+    }
+  }
+
+  return NULL;
+}
+
+VOID
+IpmiCacheUpdate (
+  IN UINT8                      NetFunction,
+  IN UINT8                      Command,
+  IN UINT8                      *CommandData,
+  IN UINT32                     CommandDataSize,
+  IN UINT8                      *ResponseData,
+  IN UINT32                     ResponseDataSize
+  )
+/*++
+
+Routine Description:
+
+  Cache the response to a command, if it is one of the cached commands and it
+  completed normally. When the cache is full the entries are replaced in turn.
+
+Arguments:
+
+  NetFunction       - Net Function of the command
+  Command           - IPMI command
+  CommandData       - Pointer to command data buffer
+  CommandDataSize   - Size of command data buffer
+  ResponseData      - Completion code followed by the response data
+  ResponseDataSize  - Size of the response data buffer
+
+Returns:
+
+  VOID
+
+--*/
+{
+  IPMI_RESPONSE_CACHE_ENTRY   *Entry;
+  UINT8                       Key[IPMI_CACHE_KEY_SIZE];
+  UINT8                       KeySize;
+
+  if ((ResponseDataSize == 0) || (ResponseDataSize > MAX_TEMP_DATA) ||
+      (ResponseData[0] != COMP_CODE_NORMAL)) {
+    return;
+  }
+
+  if (!IpmiCacheGetKey (NetFunction, Command, CommandData, CommandDataSize, Key, &KeySize)) {
+    return;
+  }
+
+  Entry = IpmiCacheLookup (NetFunction, Command, CommandData, CommandDataSize);
+  if (Entry == NULL) {
+    Entry = &mResponseCache[mResponseCacheNext];
+    mResponseCacheNext = (mResponseCacheNext + 1) % IPMI_CACHE_ENTRIES;
+  }
+
+  Entry->Valid        = TRUE;
+  Entry->NetFunction  = NetFunction;
+  Entry->Command      = Command;
+  Entry->KeySize      = KeySize;
+  CopyMem (Entry->Key, Key, KeySize);
+  Entry->ResponseSize = (UINT8) ResponseDataSize;
+  CopyMem (Entry->Response, ResponseData, ResponseDataSize);
+}
+
+IPMI_ASYNC_REQUEST *
+IpmiAsyncActiveRequest (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Find the oldest queued request that has not completed yet.
+
+Arguments:
+
+  None
+
+Returns:
+
+  Pointer to the request, or NULL if every queued request has completed
+
+--*/
+{
+  LIST_ENTRY          *Link;
+  IPMI_ASYNC_REQUEST  *Request;
+
+  for (Link = GetFirstNode (&mAsyncQueue); !IsNull (&mAsyncQueue, Link); Link = GetNextNode (&mAsyncQueue, Link)) {
+    Request = IPMI_ASYNC_REQUEST_FROM_LINK (Link);
+    if (!Request->Done) {
+      return Request;
+    }
+  }
+
+  return NULL;
+}
+
+EFI_STATUS
+IpmiAsyncKcsStep (
+  IN OUT IPMI_ASYNC_REQUEST     *Request
+  )
+/*++
+
+Routine Description:
+
+  Read the KCS status once and, if the BMC is ready, move the transfer of
+  Request one byte forward. This follows the same handshake as SendDataToBmc
+  and ReceiveBmcData.
+
+Arguments:
+
+  Request       - The request at the head of the queue
+
+Returns:
+
+  EFI_SUCCESS       - The transfer moved forward
+  EFI_NOT_READY     - The BMC is still busy
+  EFI_DEVICE_ERROR  - The KCS interface is in an unexpected state, the caller
+                      aborts the transfer with KcsErrorExit
+
+--*/
+{
+  UINT16      KcsPort;
+  KCS_STATUS  KcsStatus;
+
+  KcsPort = mAsyncIpmiInstance->IpmiIoBase;
+
+  KcsStatus.RawData = IoRead8 (KcsPort + 1);
+  if (KcsStatus.RawData == 0xFF) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  switch (mAsyncTransfer.State) {
+    case KcsAsyncWriteStart:
+      if (KcsStatus.Status.Ibf) {
+        return EFI_NOT_READY;
+      }
+
+      IoWrite8 ((KcsPort + 1), KCS_WRITE_START);
+      mAsyncTransfer.State = KcsAsyncWrite;
+      break;
+
+    case KcsAsyncWrite:
+      if (KcsStatus.Status.Ibf) {
+        return EFI_NOT_READY;
+      }
+
+      IoRead8 (KcsPort);
+      if (KcsStatus.Status.State != KcsWriteState) {
+        return EFI_DEVICE_ERROR;
+      }
+
+      if ((mAsyncTransfer.Index == (Request->RequestSize - 1)) && !mAsyncTransfer.WriteEndSent) {
+        IoWrite8 ((KcsPort + 1), KCS_WRITE_END);
+        mAsyncTransfer.WriteEndSent = TRUE;
+        break;
+      }
+
+      IoWrite8 (KcsPort, Request->Request[mAsyncTransfer.Index]);
+      mAsyncTransfer.Index++;
+      if (mAsyncTransfer.Index == Request->RequestSize) {
+        mAsyncTransfer.State = KcsAsyncReadStatus;
+      }
+      break;
+
+    case KcsAsyncReadStatus:
+      if (KcsStatus.Status.Ibf) {
+        return EFI_NOT_READY;
+      }
+
+      if (KcsStatus.Status.State == KcsReadState) {
+        mAsyncTransfer.State = KcsAsyncReadData;
+      } else if (KcsStatus.Status.State == KcsIdleState) {
+        mAsyncTransfer.State = KcsAsyncReadDone;
+      } else {
+        return EFI_DEVICE_ERROR;
+      }
+      break;
+
+    case KcsAsyncReadData:
+      if (!KcsStatus.Status.Obf) {
+        return EFI_NOT_READY;
+      }
+
+      //
+      // Keep the last byte free, like the synchronous path does.
+      //
+      if (Request->ResponseSize >= (MAX_TEMP_DATA - 1)) {
+        return EFI_DEVICE_ERROR;
+      }
+
+      Request->Response[Request->ResponseSize] = IoRead8 (KcsPort);
+      Request->ResponseSize++;
+      IoWrite8 (KcsPort, KCS_READ);
+      mAsyncTransfer.State = KcsAsyncReadStatus;
+      break;
+
+    case KcsAsyncReadDone:
+      if (!KcsStatus.Status.Obf) {
+        return EFI_NOT_READY;
+      }
+
+      IoRead8 (KcsPort);
+      mAsyncTransfer.State = KcsAsyncComplete;
+      break;
+
+    default:
+      ASSERT (FALSE);
+      return EFI_DEVICE_ERROR;
+  }
+
+  mAsyncTransfer.WaitTime = 0;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+IpmiAsyncCheckResponse (
+  IN IPMI_ASYNC_REQUEST         *Request
+  )
+/*++
+
+Routine Description:
+
+  Check the response to a request and update the BMC status the same way
+  IpmiSendCommandToBmc does.
+
+Arguments:
+
+  Request       - The completed request
+
+Returns:
+
+  EFI_DEVICE_ERROR        - IPMI command failed
+  EFI_UNSUPPORTED         - Command is not supported by BMC
+  EFI_SECURITY_VIOLATION  - The KCS channel is not allowed to send the command
+  EFI_SUCCESS             - Command completed successfully
+
+--*/
+{
+  IPMI_RESPONSE   *IpmiResponse;
+
+  IpmiResponse = (IPMI_RESPONSE *) Request->Response;
+
+  if (Request->ResponseSize < IPMI_RESPONSE_HEADER_SIZE) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (IpmiResponse->CompletionCode != COMP_CODE_NORMAL) {
+    UpdateErrorStatus (IpmiResponse->CompletionCode, mAsyncIpmiInstance);
+    if (mAsyncIpmiInstance->BmcStatus == BMC_UPDATE_IN_PROGRESS) {
+      return EFI_UNSUPPORTED;
+    } else if (IpmiResponse->CompletionCode == COMP_INSUFFICIENT_PRIVILEGE) {
+      return EFI_SECURITY_VIOLATION;
+    } else {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  if ((IpmiResponse->NetFunction != (Request->NetFunction | 0x1)) || (IpmiResponse->Command != Request->Command)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  mAsyncIpmiInstance->BmcStatus = BMC_OK;
+
+  IpmiCacheUpdate (
+    Request->NetFunction,
+    Request->Command,
+    &Request->Request[IPMI_COMMAND_HEADER_SIZE],
+    Request->RequestSize - IPMI_COMMAND_HEADER_SIZE,
+    &IpmiResponse->CompletionCode,
+    Request->ResponseSize - (IPMI_RESPONSE_HEADER_SIZE - 1)
+    );
+
+  return EFI_SUCCESS;
+}
+
+VOID
+IpmiAsyncRun (
+  IN UINT64                     Budget,
+  IN BOOLEAN                    AllRequests
+  )
+/*++
+
+Routine Description:
+
+  Move queued requests across the KCS interface until the BMC has kept us
+  waiting for Budget microseconds.
+
+Arguments:
+
+  Budget        - Time to wait on the BMC, in microseconds
+  AllRequests   - TRUE to start the next request when one completes, FALSE
+                  to stop once the transfer in progress, if any, is complete
+
+Returns:
+
+  VOID
+
+--*/
+{
+  IPMI_ASYNC_REQUEST  *Request;
+  EFI_STATUS          Status;
+
+  while (TRUE) {
+    if ((mAsyncTransfer.State == KcsAsyncIdle) && !AllRequests) {
+      return;
+    }
+
+    Request = IpmiAsyncActiveRequest ();
+    if (Request == NULL) {
+      mAsyncTransfer.State = KcsAsyncIdle;
+      return;
+    }
+
+    if (mAsyncTransfer.State == KcsAsyncIdle) {
+      ZeroMem (&mAsyncTransfer, sizeof (mAsyncTransfer));
+      mAsyncTransfer.State  = KcsAsyncWriteStart;
+      Request->ResponseSize = 0;
+    }
+
+    Status = IpmiAsyncKcsStep (Request);
+    if (Status == EFI_NOT_READY) {
+      if (mAsyncTransfer.WaitTime < IPMI_ASYNC_TIMEOUT) {
+        if (Budget < KCS_DELAY_UNIT) {
+          return;
+        }
+        MicroSecondDelay (KCS_DELAY_UNIT);
+        mAsyncTransfer.WaitTime += KCS_DELAY_UNIT;
+        Budget -= KCS_DELAY_UNIT;
+        continue;
+      }
+      Status = EFI_DEVICE_ERROR;
+    }
+
+    if (EFI_ERROR (Status)) {
+      //
+      // Abort the transfer like the synchronous path does, so that the next
+      // request starts from an idle interface.
+      //
+      KcsErrorExit (mAsyncIpmiInstance->KcsTimeoutPeriod, mAsyncIpmiInstance->IpmiIoBase, NULL);
+      mAsyncIpmiInstance->BmcStatus = BMC_SOFTFAIL;
+      mAsyncIpmiInstance->SoftErrorCount++;
+    } else if (mAsyncTransfer.State == KcsAsyncComplete) {
+      Status = IpmiAsyncCheckResponse (Request);
+    } else {
+      continue;
+    }
+
+    //
+    // Flush the cache again once the command has run: a read that was queued
+    // before it may have cached data the command has since changed.
+    //
+    if (IpmiCacheInvalidatedBy (Request->NetFunction, Request->Command)) {
+      IpmiCacheFlush ();
+    }
+
+    Request->Status      = Status;
+    Request->Done        = TRUE;
+    mAsyncTransfer.State = KcsAsyncIdle;
+  }
+}
+
+VOID
+IpmiAsyncDispatch (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Remove completed requests from the head of the queue and call their
+  completion callbacks, in the order the requests were submitted.
+
+Arguments:
+
+  None
+
+Returns:
+
+  VOID
+
+--*/
+{
+  IPMI_ASYNC_REQUEST  *Request;
+
+  while (!IsListEmpty (&mAsyncQueue)) {
+    Request = IPMI_ASYNC_REQUEST_FROM_LINK (GetFirstNode (&mAsyncQueue));
+    if (!Request->Done) {
+      break;
+    }
+
+    RemoveEntryList (&Request->Link);
+
+    if (Request->CompletionCallback != NULL) {
+      if (Request->ResponseSize >= IPMI_RESPONSE_HEADER_SIZE) {
+        Request->CompletionCallback (
+                   Request->Status,
+                   &Request->Response[IPMI_RESPONSE_HEADER_SIZE - 1],
+                   Request->ResponseSize - (IPMI_RESPONSE_HEADER_SIZE - 1),
+                   Request->Context
+                   );
+      } else {
+        Request->CompletionCallback (Request->Status, NULL, 0, Request->Context);
+      }
+    }
+
+    FreePool (Request);
+  }
+}
+
+VOID
+IpmiAsyncUpdateTimer (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Run the poll timer while there are queued requests, and only then.
+
+Arguments:
+
+  None
+
+Returns:
+
+  VOID
+
+--*/
+{
+  if (IsListEmpty (&mAsyncQueue)) {
+    if (mAsyncTimerRunning) {
+      gBS->SetTimer (mAsyncTimerEvent, TimerCancel, 0);
+      mAsyncTimerRunning = FALSE;
+    }
+  } else if (!mAsyncTimerRunning && (mAsyncTimerEvent != NULL)) {
+    gBS->SetTimer (mAsyncTimerEvent, TimerPeriodic, IPMI_ASYNC_TIMER_PERIOD * 10);
+    mAsyncTimerRunning = TRUE;
+  }
+}
+
+VOID
+EFIAPI
+IpmiAsyncTimerHandler (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+/*++
+
+Routine Description:
+
+  Poll timer notification function. Moves the queued requests forward and
+  reports the ones that completed.
+
+Arguments:
+
+  Event         - The poll timer event
+  Context       - Not used
+
+Returns:
+
+  VOID
+
+--*/
+{
+  if (mAsyncBusy) {
+    return;
+  }
+
+  mAsyncBusy = TRUE;
+  if (mAsyncTransfer.State != KcsAsyncIdle) {
+    mAsyncTransfer.WaitTime += IPMI_ASYNC_TIMER_PERIOD;
+  }
+  IpmiAsyncRun (IPMI_ASYNC_POLL_BUDGET, TRUE);
+  mAsyncBusy = FALSE;
+
+  IpmiAsyncDispatch ();
+  IpmiAsyncUpdateTimer ();
+}
+
+EFI_STATUS
+EFIAPI
+IpmiSubmitCommandAsync (
+  IN IPMI_TRANSPORT_ASYNC              *This,
+  IN UINT8                             NetFunction,
+  IN UINT8                             Lun,
+  IN UINT8                             Command,
+  IN UINT8                             *CommandData,
+  IN UINT32                            CommandDataSize,
+  IN IPMI_ASYNC_COMMAND_COMPLETE       CompletionCallback  OPTIONAL,
+  IN VOID                              *Context            OPTIONAL
+  )
+/*++
+
+Routine Description:
+
+  Queue an IPMI command to the BMC and return without waiting for it.
+
+Arguments:
+
+  This                - Pointer to the protocol instance
+  NetFunction         - Net Function of command to send
+  Lun                 - LUN of command to send
+  Command             - IPMI command to send
+  CommandData         - Pointer to command data buffer, if needed
+  CommandDataSize     - Size of command data buffer
+  CompletionCallback  - Called when the command completes
+  Context             - Passed to CompletionCallback
+
+Returns:
+
+  EFI_INVALID_PARAMETER - One of the input values is bad
+  EFI_OUT_OF_RESOURCES  - The command could not be queued
+  EFI_UNSUPPORTED       - Called above TPL_CALLBACK
+  EFI_SUCCESS           - The command was queued
+
+--*/
+{
+  IPMI_ASYNC_REQUEST          *Request;
+  IPMI_COMMAND                *IpmiCommand;
+  IPMI_RESPONSE_CACHE_ENTRY   *Entry;
+  EFI_TPL                     OldTpl;
+
+  if ((CommandDataSize > (MAX_TEMP_DATA - IPMI_COMMAND_HEADER_SIZE)) ||
+      ((CommandDataSize > 0) && (CommandData == NULL))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (EfiGetCurrentTpl () > TPL_CALLBACK) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Request = AllocateZeroPool (sizeof (*Request));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request->Signature          = IPMI_ASYNC_REQUEST_SIGNATURE;
+  Request->CompletionCallback = CompletionCallback;
+  Request->Context            = Context;
+  Request->NetFunction        = NetFunction;
+  Request->Command            = Command;
+
+  IpmiCommand = (IPMI_COMMAND *) Request->Request;
+  IpmiCommand->Lun         = Lun;
+  IpmiCommand->NetFunction = NetFunction;
+  IpmiCommand->Command     = Command;
+  if (CommandDataSize > 0) {
+    CopyMem (IpmiCommand->CommandData, CommandData, CommandDataSize);
+  }
+  Request->RequestSize = (UINT8) (CommandDataSize + IPMI_COMMAND_HEADER_SIZE);
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  if (IpmiCacheInvalidatedBy (NetFunction, Command)) {
+    IpmiCacheFlush ();
+  } else if (IsListEmpty (&mAsyncQueue)) {
+    //
+    // Only use the cache when nothing is queued ahead of the command, as a
+    // queued command may change the data before this one would have run.
+    //
+    Entry = IpmiCacheLookup (NetFunction, Command, CommandData, CommandDataSize);
+    if (Entry != NULL) {
+      Request->ResponseSize = Entry->ResponseSize + (IPMI_RESPONSE_HEADER_SIZE - 1);
+      CopyMem (&Request->Response[IPMI_RESPONSE_HEADER_SIZE - 1], Entry->Response, Entry->ResponseSize);
+      Request->Status = EFI_SUCCESS;
+      Request->Done   = TRUE;
+    }
+  }
+
+  InsertTailList (&mAsyncQueue, &Request->Link);
+  IpmiAsyncUpdateTimer ();
+
+  gBS->RestoreTPL (OldTpl);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+IpmiAsyncFlush (
+  IN IPMI_TRANSPORT_ASYNC              *This
+  )
+/*++
+
+Routine Description:
+
+  Wait until every queued IPMI command has completed and been reported.
+
+Arguments:
+
+  This          - Pointer to the protocol instance
+
+Returns:
+
+  EFI_NOT_READY - Called above TPL_CALLBACK, or while a command is being transferred
+  EFI_SUCCESS   - The queue is empty
+
+--*/
+{
+  EFI_TPL   OldTpl;
+
+  if (EfiGetCurrentTpl () > TPL_CALLBACK) {
+    return EFI_NOT_READY;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  if (mAsyncBusy) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_NOT_READY;
+  }
+
+  //
+  // Completion callbacks may queue more commands, so loop until the queue stays empty.
+  //
+  while (!IsListEmpty (&mAsyncQueue)) {
+    mAsyncBusy = TRUE;
+    IpmiAsyncRun (MAX_UINT64, TRUE);
+    mAsyncBusy = FALSE;
+    IpmiAsyncDispatch ();
+  }
+
+  IpmiAsyncUpdateTimer ();
+  gBS->RestoreTPL (OldTpl);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+IpmiDxeSendCommand (
+  IN      IPMI_TRANSPORT               *This,
+  IN      UINT8                        NetFunction,
+  IN      UINT8                        Lun,
+  IN      UINT8                        Command,
+  IN      UINT8                        *CommandData,
+  IN      UINT32                       CommandDataSize,
+  IN OUT  UINT8                        *ResponseData,
+  IN OUT  UINT32                       *ResponseDataSize
+  )
+/*++
+
+Routine Description:
+
+  Send an IPMI command to the BMC and wait for the response. Serves SDR/FRU
+  reads from the response cache and waits for the KCS transfer of any queued
+  asynchronous command to finish before using the interface.
+
+Arguments:
+
+  This              - Pointer to IPMI protocol instance
+  NetFunction       - Net Function of command to send
+  Lun               - LUN of command to send
+  Command           - IPMI command to send
+  CommandData       - Pointer to command data buffer, if needed
+  CommandDataSize   - Size of command data buffer
+  ResponseData      - Pointer to response data buffer
+  ResponseDataSize  - Pointer to response data buffer size
+
+Returns:
+
+  EFI_INVALID_PARAMETER - One of the input values is bad
+  EFI_DEVICE_ERROR      - IPMI command failed
+  EFI_BUFFER_TOO_SMALL  - Response buffer is too small
+  EFI_UNSUPPORTED       - Command is not supported by BMC
+  EFI_NOT_READY         - Called while the KCS interface is in use at a lower TPL
+  EFI_SUCCESS           - Command completed successfully
+
+--*/
+{
+  EFI_STATUS                  Status;
+  EFI_TPL                     OldTpl;
+  EFI_TPL                     CurrentTpl;
+  IPMI_RESPONSE_CACHE_ENTRY   *Entry;
+  BOOLEAN                     Invalidate;
+
+  if ((ResponseData == NULL) || (ResponseDataSize == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CurrentTpl = EfiGetCurrentTpl ();
+  OldTpl     = gBS->RaiseTPL (MAX (CurrentTpl, TPL_CALLBACK));
+
+  //
+  // The poll timer was interrupted in the middle of a KCS transfer.
+  //
+  if (mAsyncBusy) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_NOT_READY;
+  }
+
+  Invalidate = IpmiCacheInvalidatedBy (NetFunction, Command);
+  if (Invalidate) {
+    IpmiCacheFlush ();
+  } else {
+    Entry = IpmiCacheLookup (NetFunction, Command, CommandData, CommandDataSize);
+    if ((Entry != NULL) && (Entry->ResponseSize <= *ResponseDataSize)) {
+      CopyMem (ResponseData, Entry->Response, Entry->ResponseSize);
+      *ResponseDataSize = Entry->ResponseSize;
+      gBS->RestoreTPL (OldTpl);
+      return EFI_SUCCESS;
+    }
+  }
+
+  //
+  // Finish the transfer of the queued command in progress so the interface is
+  // idle. Its completion is reported from the next poll timer tick.
+  //
+  if (mAsyncTransfer.State != KcsAsyncIdle) {
+    mAsyncBusy = TRUE;
+    IpmiAsyncRun (MAX_UINT64, FALSE);
+    mAsyncBusy = FALSE;
+  }
+
+  Status = IpmiSendCommand (
+             This,
+             NetFunction,
+             Lun,
+             Command,
+             CommandData,
+             CommandDataSize,
+             ResponseData,
+             ResponseDataSize
+             );
+  if (!EFI_ERROR (Status) && !Invalidate) {
+    IpmiCacheUpdate (NetFunction, Command, CommandData, CommandDataSize, ResponseData, *ResponseDataSize);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+VOID
+EFIAPI
+IpmiAsyncExitBootServices (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+/*++
+
+Routine Description:
+
+  Stop the poll timer and send the queued commands to the BMC. Their
+  completion callbacks are not called, boot services are going away.
+
+Arguments:
+
+  Event         - The ExitBootServices event
+  Context       - Not used
+
+Returns:
+
+  VOID
+
+--*/
+{
+  if (mAsyncTimerRunning) {
+    gBS->SetTimer (mAsyncTimerEvent, TimerCancel, 0);
+    mAsyncTimerRunning = FALSE;
+  }
+
+  if (!mAsyncBusy) {
+    mAsyncBusy = TRUE;
+    IpmiAsyncRun (MAX_UINT64, TRUE);
+  }
+}
+
+STATIC IPMI_TRANSPORT_ASYNC  mIpmiTransportAsync = {
+  IpmiSubmitCommandAsync,
+  IpmiAsyncFlush
+};
+
+EFI_STATUS
+InitializeIpmiAsync (
+  IN     IPMI_BMC_INSTANCE_DATA *IpmiInstance,
+  IN OUT EFI_HANDLE             *Handle
+  )
+/*++
+
+Routine Description:
+
+  Create the poll timer and ExitBootServices event and install the
+  asynchronous IPMI transport protocol on Handle.
+
+Arguments:
+
+  IpmiInstance  - BMC instance data
+  Handle        - Handle the IPMI transport protocol was installed on
+
+Returns:
+
+  EFI_SUCCESS   - The protocol was installed
+  Others        - The events could not be created or the protocol installed
+
+--*/
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   ExitBootServicesEvent;
+
+  mAsyncIpmiInstance = IpmiInstance;
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  IpmiAsyncTimerHandler,
+                  NULL,
+                  &mAsyncTimerEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  IpmiAsyncExitBootServices,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &ExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (mAsyncTimerEvent);
+    mAsyncTimerEvent = NULL;
+    return Status;
+  }
+
+  Status = gBS->InstallProtocolInterface (
+                  Handle,
+                  &gIpmiTransportAsyncProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &mIpmiTransportAsync
+                  );
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (ExitBootServicesEvent);
+    gBS->CloseEvent (mAsyncTimerEvent);
+    mAsyncTimerEvent = NULL;
+  }
+
+  return Status;
+}
@@ -0,0 +1,154 @@
+/** @file
+  Asynchronous KCS transport and response cache for the Generic IPMI DXE driver.
+
+  @copyright
+  Copyright 2026 Intel Corporation. <BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _IPMI_ASYNC_H_
+#define _IPMI_ASYNC_H_
+
+#include <IndustryStandard/Ipmi.h>
+#include <Protocol/IpmiTransportAsyncProtocol.h>
+#include <Guid/EventGroup.h>
+#include "IpmiHooks.h"
+#include "IpmiBmcCommon.h"
+#include "IpmiBmc.h"
+
+#define IPMI_ASYNC_REQUEST_SIGNATURE  SIGNATURE_32 ('i', 'p', 'm', 'q')
+
+#define IPMI_ASYNC_TIMER_PERIOD       1000                    // [us] Poll period while commands are queued
+#define IPMI_ASYNC_POLL_BUDGET        (KCS_DELAY_UNIT * 4)    // [us] Time spent waiting on the BMC per tick
+#define IPMI_ASYNC_TIMEOUT            (BMC_KCS_TIMEOUT * 1000 * 1000) // [us] Single KCS transfer step timeout
+
+#define IPMI_CACHE_ENTRIES            32
+#define IPMI_CACHE_KEY_SIZE           8
+
+//
+// Progress of the KCS transfer of the request at the head of the queue.
+// Every state waits for one status bit before it moves the transfer forward.
+//
+typedef enum {
+  KcsAsyncIdle,
+  KcsAsyncWriteStart,   // Waiting for IBF clear to send WRITE_START
+  KcsAsyncWrite,        // Waiting for IBF clear to send the next byte
+  KcsAsyncReadStatus,   // Waiting for IBF clear to check the read state
+  KcsAsyncReadData,     // Waiting for OBF set to read the next byte
+  KcsAsyncReadDone,     // Waiting for OBF set to read the dummy byte
+  KcsAsyncComplete
+} KCS_ASYNC_STATE;
+
+typedef struct {
+  UINTN                         Signature;
+  LIST_ENTRY                    Link;
+  IPMI_ASYNC_COMMAND_COMPLETE   CompletionCallback;
+  VOID                          *Context;
+  UINT8                         NetFunction;
+  UINT8                         Command;
+  UINT8                         RequestSize;
+  UINT8                         Request[MAX_TEMP_DATA];
+  UINT8                         ResponseSize;
+  UINT8                         Response[MAX_TEMP_DATA];
+  EFI_STATUS                    Status;
+  BOOLEAN                       Done;
+} IPMI_ASYNC_REQUEST;
+
+#define IPMI_ASYNC_REQUEST_FROM_LINK(a) \
+  CR ( \
+  a, \
+  IPMI_ASYNC_REQUEST, \
+  Link, \
+  IPMI_ASYNC_REQUEST_SIGNATURE \
+  )
+
+typedef struct {
+  KCS_ASYNC_STATE               State;
+  UINT8                         Index;
+  BOOLEAN                       WriteEndSent;
+  UINT64                        WaitTime;
+} KCS_ASYNC_TRANSFER;
+
+//
+// Responses to the SDR/FRU read commands, which are sent repeatedly while
+// SMBIOS and the setup pages are built but only change when the BMC does.
+//
+typedef struct {
+  BOOLEAN                       Valid;
+  UINT8                         NetFunction;
+  UINT8                         Command;
+  UINT8                         KeySize;
+  UINT8                         Key[IPMI_CACHE_KEY_SIZE];
+  UINT8                         ResponseSize;
+  UINT8                         Response[MAX_TEMP_DATA];
+} IPMI_RESPONSE_CACHE_ENTRY;
+
+EFI_STATUS
+EFIAPI
+IpmiDxeSendCommand (
+  IN      IPMI_TRANSPORT               *This,
+  IN      UINT8                        NetFunction,
+  IN      UINT8                        Lun,
+  IN      UINT8                        Command,
+  IN      UINT8                        *CommandData,
+  IN      UINT32                       CommandDataSize,
+  IN OUT  UINT8                        *ResponseData,
+  IN OUT  UINT32                       *ResponseDataSize
+  )
+/*++
+
+Routine Description:
+
+  Send an IPMI command to the BMC and wait for the response. Serves SDR/FRU
+  reads from the response cache and waits for the KCS transfer of any queued
+  asynchronous command to finish before using the interface.
+
+Arguments:
+
+  This              - Pointer to IPMI protocol instance
+  NetFunction       - Net Function of command to send
+  Lun               - LUN of command to send
+  Command           - IPMI command to send
+  CommandData       - Pointer to command data buffer, if needed
+  CommandDataSize   - Size of command data buffer
+  ResponseData      - Pointer to response data buffer
+  ResponseDataSize  - Pointer to response data buffer size
+
+Returns:
+
+  EFI_INVALID_PARAMETER - One of the input values is bad
+  EFI_DEVICE_ERROR      - IPMI command failed
+  EFI_BUFFER_TOO_SMALL  - Response buffer is too small
+  EFI_UNSUPPORTED       - Command is not supported by BMC
+  EFI_NOT_READY         - Called while the KCS interface is in use at a lower TPL
+  EFI_SUCCESS           - Command completed successfully
+
+--*/
+;
+
+EFI_STATUS
+InitializeIpmiAsync (
+  IN     IPMI_BMC_INSTANCE_DATA *IpmiInstance,
+  IN OUT EFI_HANDLE             *Handle
+  )
+/*++
+
+Routine Description:
+
+  Create the poll timer and ExitBootServices event and install the
+  asynchronous IPMI transport protocol on Handle.
+
+Arguments:
+
+  IpmiInstance  - BMC instance data
+  Handle        - Handle the IPMI transport protocol was installed on
+
+Returns:
+
+  EFI_SUCCESS   - The protocol was installed
+  Others        - The events could not be created or the protocol installed
+
+--*/
+;
+
+#endif
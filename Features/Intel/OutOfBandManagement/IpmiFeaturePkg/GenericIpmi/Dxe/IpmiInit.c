@@ -12,6 +12,7 @@
 #include "IpmiBmcCommon.h"
 #include "IpmiBmc.h"
 #include "IpmiPhysicalLayer.h"
+#include "IpmiAsync.h"
 #include <Library/TimerLib.h>
 #ifdef FAST_VIDEO_SUPPORT
   #include <Protocol/VideoPrint.h>
@@ -405,7 +406,7 @@ InitializeIpmiKcsPhysicalLayer (
     mIpmiInstance->Signature                        = SM_IPMI_BMC_SIGNATURE;
     mIpmiInstance->SlaveAddress                     = BMC_SLAVE_ADDRESS;
     mIpmiInstance->BmcStatus                        = BMC_NOTREADY;
-    mIpmiInstance->IpmiTransport.IpmiSubmitCommand  = IpmiSendCommand;
+    mIpmiInstance->IpmiTransport.IpmiSubmitCommand  = IpmiDxeSendCommand;
     mIpmiInstance->IpmiTransport.GetBmcStatus       = IpmiGetBmcStatus;
 
     //
@@ -453,6 +454,9 @@ InitializeIpmiKcsPhysicalLayer (
                       &mIpmiInstance->IpmiTransport
                       );
       ASSERT_EFI_ERROR (Status);
+
+      Status = InitializeIpmiAsync (mIpmiInstance, &Handle);
+      ASSERT_EFI_ERROR (Status);
     }
 
     return EFI_SUCCESS;
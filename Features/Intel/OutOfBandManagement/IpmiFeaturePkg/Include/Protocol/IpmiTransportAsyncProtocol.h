@@ -0,0 +1,103 @@
+/** @file
+  IPMI Asynchronous Transport Protocol Header File.
+
+  Queues IPMI commands to the BMC without waiting for them. The KCS transfer
+  runs from a timer event and the caller is notified through a completion
+  callback, so the boot CPU is free while the BMC works on the command.
+
+  @copyright
+  Copyright 2026 Intel Corporation. <BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _IPMI_TRANSPORT_ASYNC_PROTO_H_
+#define _IPMI_TRANSPORT_ASYNC_PROTO_H_
+
+#include <ServerManagement.h>
+
+typedef struct _IPMI_TRANSPORT_ASYNC IPMI_TRANSPORT_ASYNC;
+
+#define IPMI_TRANSPORT_ASYNC_PROTOCOL_GUID \
+  { \
+    0x38893db6, 0x4eef, 0x4752, 0x98, 0x8b, 0x1b, 0x81, 0x23, 0xc2, 0x4e, 0xb5 \
+  }
+
+/**
+  Called at TPL_CALLBACK when a queued IPMI command completes.
+
+  @param[in] Status            EFI_SUCCESS if the BMC returned a normal completion code,
+                               or the same error IpmiSubmitCommand would have returned.
+  @param[in] ResponseData      Completion code followed by the response data, in the same
+                               format as IpmiSubmitCommand. Only valid during the callback.
+                               NULL if the BMC did not respond.
+  @param[in] ResponseDataSize  Size of ResponseData in bytes.
+  @param[in] Context           Context passed to IpmiSubmitCommandAsync.
+**/
+typedef
+VOID
+(EFIAPI *IPMI_ASYNC_COMMAND_COMPLETE) (
+  IN EFI_STATUS                        Status,
+  IN UINT8                             *ResponseData,
+  IN UINT32                            ResponseDataSize,
+  IN VOID                              *Context
+  );
+
+/**
+  Queue an IPMI command to the BMC and return without waiting for it.
+
+  Commands are sent in the order they were queued. The command data is copied,
+  so the caller's buffer can be released on return. Must be called at
+  TPL_CALLBACK or lower.
+
+  @param[in] This                Pointer to the protocol instance.
+  @param[in] NetFunction         Net Function of command to send.
+  @param[in] Lun                 LUN of command to send.
+  @param[in] Command             IPMI command to send.
+  @param[in] CommandData         Pointer to command data buffer, if needed.
+  @param[in] CommandDataSize     Size of command data buffer.
+  @param[in] CompletionCallback  Called when the command completes. Optional.
+  @param[in] Context             Passed to CompletionCallback.
+
+  @retval EFI_SUCCESS            The command was queued.
+  @retval EFI_INVALID_PARAMETER  The command data is too large, or NULL with a non-zero size.
+  @retval EFI_OUT_OF_RESOURCES   The command could not be queued.
+  @retval EFI_UNSUPPORTED        Called above TPL_CALLBACK.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *IPMI_SUBMIT_COMMAND_ASYNC) (
+  IN IPMI_TRANSPORT_ASYNC              *This,
+  IN UINT8                             NetFunction,
+  IN UINT8                             Lun,
+  IN UINT8                             Command,
+  IN UINT8                             *CommandData,
+  IN UINT32                            CommandDataSize,
+  IN IPMI_ASYNC_COMMAND_COMPLETE       CompletionCallback  OPTIONAL,
+  IN VOID                              *Context            OPTIONAL
+  );
+
+/**
+  Wait until every queued IPMI command has completed.
+
+  @param[in] This                Pointer to the protocol instance.
+
+  @retval EFI_SUCCESS            The queue is empty.
+  @retval EFI_NOT_READY          Called above TPL_CALLBACK, or while a command is being transferred.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *IPMI_ASYNC_FLUSH) (
+  IN IPMI_TRANSPORT_ASYNC              *This
+  );
+
+//
+// IPMI TRANSPORT ASYNC PROTOCOL
+//
+struct _IPMI_TRANSPORT_ASYNC {
+  IPMI_SUBMIT_COMMAND_ASYNC   IpmiSubmitCommandAsync;
+  IPMI_ASYNC_FLUSH            Flush;
+};
+
+extern EFI_GUID gIpmiTransportAsyncProtocolGuid;
+
+#endif
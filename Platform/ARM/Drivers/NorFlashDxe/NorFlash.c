@@ -7,6 +7,7 @@
 
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 
 #include "NorFlash.h"
@@ -594,6 +595,154 @@ NorFlashRead (
   return EFI_SUCCESS;
 }
 
+/**
+  Checks whether programming Buffer over the current flash contents would need
+  to flip a bit from 0 to 1. Programming can only clear bits, so such a write
+  needs the block to be erased first.
+
+  @param[in]  FlashData   Current contents of the flash.
+  @param[in]  Buffer      Data to be written.
+  @param[in]  Length      Length of both buffers in bytes.
+
+  @retval TRUE            The block must be erased before writing Buffer.
+  @retval FALSE           Buffer can be programmed over the current contents.
+
+**/
+STATIC
+BOOLEAN
+NorFlashWriteNeedsErase (
+  IN CONST UINT8  *FlashData,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  UINTN  Index;
+
+  // Check 8 bytes at a time. Neither buffer has to be aligned.
+  for (Index = 0; Index + sizeof (UINT64) <= Length; Index += sizeof (UINT64)) {
+    if ((~ReadUnaligned64 ((CONST UINT64 *)(FlashData + Index)) &
+         ReadUnaligned64 ((CONST UINT64 *)(Buffer + Index))) != 0)
+    {
+      return TRUE;
+    }
+  }
+
+  for ( ; Index < Length; Index++) {
+    if ((~FlashData[Index] & Buffer[Index]) != 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Writes a portion of a block without erasing it, if the write only changes
+  bits from 1 to 0.
+
+  The write is done in chunks of the size of the device write buffer, and
+  chunks whose data are already on flash are skipped. A chunk with changes in
+  a single word is written with a word program, any other with a buffered
+  program.
+
+  @param[in]  Instance    NOR flash instance.
+  @param[in]  Lba         Block to write to.
+  @param[in]  Offset      Offset into the block. Offset + NumBytes must not
+                          exceed the block size.
+  @param[in]  NumBytes    Number of bytes to write.
+  @param[in]  Buffer      Data to write.
+
+  @retval EFI_SUCCESS       The data was written.
+  @retval EFI_UNSUPPORTED   The block must be erased to write the data. Nothing
+                            was written.
+  @retval EFI_DEVICE_ERROR  The data could not be written.
+
+**/
+STATIC
+EFI_STATUS
+NorFlashWriteWithoutErase (
+  IN NOR_FLASH_INSTANCE  *Instance,
+  IN EFI_LBA             Lba,
+  IN UINTN               Offset,
+  IN UINTN               NumBytes,
+  IN UINT8               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Shadow;
+  UINTN       BlockAddress;
+  UINTN       WindowStart;
+  UINTN       WindowEnd;
+  UINTN       ChunkStart;
+  UINTN       CopyStart;
+  UINTN       CopyEnd;
+  UINTN       FirstWord;
+  UINTN       LastWord;
+  BOOLEAN     Unlocked;
+
+  // Read the buffer-aligned window around the write into the shadow buffer,
+  // at the same offsets as in the block.
+  Shadow      = Instance->ShadowBuffer;
+  WindowStart = Offset & ~(P30_MAX_BUFFER_SIZE_IN_BYTES - 1);
+  WindowEnd   = ALIGN_VALUE (Offset + NumBytes, P30_MAX_BUFFER_SIZE_IN_BYTES);
+
+  Status = NorFlashRead (Instance, Lba, WindowStart, WindowEnd - WindowStart, Shadow + WindowStart);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (NorFlashWriteNeedsErase (Shadow + Offset, Buffer, NumBytes)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  BlockAddress = GET_NOR_BLOCK_ADDRESS (Instance->RegionBaseAddress, Lba, Instance->Media.BlockSize);
+  Unlocked     = FALSE;
+
+  for (ChunkStart = WindowStart; ChunkStart < WindowEnd; ChunkStart += P30_MAX_BUFFER_SIZE_IN_BYTES) {
+    CopyStart = MAX (ChunkStart, Offset);
+    CopyEnd   = MIN (ChunkStart + P30_MAX_BUFFER_SIZE_IN_BYTES, Offset + NumBytes);
+
+    // Skip the chunk if its data is already on flash
+    if (CompareMem (Shadow + CopyStart, Buffer + (CopyStart - Offset), CopyEnd - CopyStart) == 0) {
+      continue;
+    }
+
+    CopyMem (Shadow + CopyStart, Buffer + (CopyStart - Offset), CopyEnd - CopyStart);
+
+    if (!Unlocked) {
+      Status = NorFlashUnlockSingleBlockIfNecessary (Instance, BlockAddress);
+      if (EFI_ERROR (Status)) {
+        return EFI_DEVICE_ERROR;
+      }
+
+      Unlocked = TRUE;
+    }
+
+    // Words of the chunk that hold the new data. The rest of each word is
+    // rewritten with its current contents, which leaves it unchanged.
+    FirstWord = CopyStart & ~(UINTN)0x3;
+    LastWord  = (CopyEnd - 1) & ~(UINTN)0x3;
+
+    if (FirstWord == LastWord) {
+      Status = NorFlashWriteSingleWord (Instance, BlockAddress + FirstWord, *(UINT32 *)(Shadow + FirstWord));
+    } else {
+      // Buffered programs must start on a buffer boundary
+      Status = NorFlashWriteBuffer (
+                 Instance,
+                 BlockAddress + ChunkStart,
+                 LastWord + sizeof (UINT32) - ChunkStart,
+                 (UINT32 *)(Shadow + ChunkStart)
+                 );
+    }
+
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /*
   Write a full or portion of a block. It must not span block boundaries; that is,
   Offset + *NumBytes <= Instance->Media.BlockSize.
@@ -608,19 +757,7 @@ NorFlashWriteSingleBlock (
   )
 {
   EFI_STATUS  TempStatus;
-  UINT32      Tmp;
-  UINT32      TmpBuf;
-  UINT32      WordToWrite;
-  UINT32      Mask;
-  BOOLEAN     DoErase;
-  UINTN       BytesToWrite;
-  UINTN       CurOffset;
-  UINTN       WordAddr;
   UINTN       BlockSize;
-  UINTN       BlockAddress;
-  UINTN       PrevBlockAddress;
-
-  PrevBlockAddress = 0;
 
   DEBUG ((DEBUG_BLKIO, "NorFlashWriteSingleBlock(Parameters: Lba=%ld, Offset=0x%x, *NumBytes=0x%x, Buffer @ 0x%08x)\n", Lba, Offset, *NumBytes, Buffer));
 
@@ -650,143 +787,26 @@ NorFlashWriteSingleBlock (
     return EFI_BAD_BUFFER_SIZE;
   }
 
-  // Pick 128bytes as a good start for word operations as opposed to erasing the
-  // block and writing the data regardless if an erase is really needed.
-  // It looks like most individual NV variable writes are smaller than 128bytes.
-  if (*NumBytes <= 128) {
-    // Check to see if we need to erase before programming the data into NOR.
-    // If the destination bits are only changing from 1s to 0s we can just write.
-    // After a block is erased all bits in the block is set to 1.
-    // If any byte requires us to erase we just give up and rewrite all of it.
-    DoErase      = FALSE;
-    BytesToWrite = *NumBytes;
-    CurOffset    = Offset;
-
-    while (BytesToWrite > 0) {
-      // Read full word from NOR, splice as required. A word is the smallest
-      // unit we can write.
-      TempStatus = NorFlashRead (Instance, Lba, CurOffset & ~(0x3), sizeof (Tmp), &Tmp);
-      if (EFI_ERROR (TempStatus)) {
-        return EFI_DEVICE_ERROR;
-      }
-
-      // Physical address of word in NOR to write.
-      WordAddr = (CurOffset & ~(0x3)) + GET_NOR_BLOCK_ADDRESS (
-                                          Instance->RegionBaseAddress,
-                                          Lba,
-                                          BlockSize
-                                          );
-      // The word of data that is to be written.
-      TmpBuf = *((UINT32 *)(Buffer + (*NumBytes - BytesToWrite)));
-
-      // First do word aligned chunks.
-      if ((CurOffset & 0x3) == 0) {
-        if (BytesToWrite >= 4) {
-          // Is the destination still in 'erased' state?
-          if (~Tmp != 0) {
-            // Check to see if we are only changing bits to zero.
-            if ((Tmp ^ TmpBuf) & TmpBuf) {
-              DoErase = TRUE;
-              break;
-            }
-          }
-
-          // Write this word to NOR
-          WordToWrite   = TmpBuf;
-          CurOffset    += sizeof (TmpBuf);
-          BytesToWrite -= sizeof (TmpBuf);
-        } else {
-          // BytesToWrite < 4. Do small writes and left-overs
-          Mask = ~((~0) << (BytesToWrite * 8));
-          // Mask out the bytes we want.
-          TmpBuf &= Mask;
-          // Is the destination still in 'erased' state?
-          if ((Tmp & Mask) != Mask) {
-            // Check to see if we are only changing bits to zero.
-            if ((Tmp ^ TmpBuf) & TmpBuf) {
-              DoErase = TRUE;
-              break;
-            }
-          }
-
-          // Merge old and new data. Write merged word to NOR
-          WordToWrite  = (Tmp & ~Mask) | TmpBuf;
-          CurOffset   += BytesToWrite;
-          BytesToWrite = 0;
-        }
-      } else {
-        // Do multiple words, but starting unaligned.
-        if (BytesToWrite > (4 - (CurOffset & 0x3))) {
-          Mask = ((~0) << ((CurOffset & 0x3) * 8));
-          // Mask out the bytes we want.
-          TmpBuf &= Mask;
-          // Is the destination still in 'erased' state?
-          if ((Tmp & Mask) != Mask) {
-            // Check to see if we are only changing bits to zero.
-            if ((Tmp ^ TmpBuf) & TmpBuf) {
-              DoErase = TRUE;
-              break;
-            }
-          }
-
-          // Merge old and new data. Write merged word to NOR
-          WordToWrite   = (Tmp & ~Mask) | TmpBuf;
-          BytesToWrite -= (4 - (CurOffset & 0x3));
-          CurOffset    += (4 - (CurOffset & 0x3));
-        } else {
-          // Unaligned and fits in one word.
-          Mask = (~((~0) << (BytesToWrite * 8))) << ((CurOffset & 0x3) * 8);
-          // Mask out the bytes we want.
-          TmpBuf = (TmpBuf << ((CurOffset & 0x3) * 8)) & Mask;
-          // Is the destination still in 'erased' state?
-          if ((Tmp & Mask) != Mask) {
-            // Check to see if we are only changing bits to zero.
-            if ((Tmp ^ TmpBuf) & TmpBuf) {
-              DoErase = TRUE;
-              break;
-            }
-          }
-
-          // Merge old and new data. Write merged word to NOR
-          WordToWrite  = (Tmp & ~Mask) | TmpBuf;
-          CurOffset   += BytesToWrite;
-          BytesToWrite = 0;
-        }
-      }
-
-      //
-      // Write the word to NOR.
-      //
-
-      BlockAddress = GET_NOR_BLOCK_ADDRESS (Instance->RegionBaseAddress, Lba, BlockSize);
-      if (BlockAddress != PrevBlockAddress) {
-        TempStatus = NorFlashUnlockSingleBlockIfNecessary (Instance, BlockAddress);
-        if (EFI_ERROR (TempStatus)) {
-          return EFI_DEVICE_ERROR;
-        }
-
-        PrevBlockAddress = BlockAddress;
-      }
-
-      TempStatus = NorFlashWriteSingleWord (Instance, WordAddr, WordToWrite);
-      if (EFI_ERROR (TempStatus)) {
-        return EFI_DEVICE_ERROR;
-      }
-    }
-
-    // Exit if we got here and could write all the data. Otherwise do the
-    // Erase-Write cycle.
-    if (!DoErase) {
-      return EFI_SUCCESS;
-    }
-  }
-
   // Check we did get some memory. Buffer is BlockSize.
   if (Instance->ShadowBuffer == NULL) {
     DEBUG ((DEBUG_ERROR, "FvbWrite: ERROR - Buffer not ready\n"));
     return EFI_DEVICE_ERROR;
   }
 
+  // Program the data without erasing the block if we can. Only if the write
+  // needs to flip bits from 0 to 1 do we fall back to the Erase-Write cycle.
+  TempStatus = NorFlashWriteWithoutErase (Instance, Lba, Offset, *NumBytes, Buffer);
+  if (TempStatus != EFI_UNSUPPORTED) {
+    if (EFI_ERROR (TempStatus)) {
+      // Return one of the pre-approved error statuses
+      return EFI_DEVICE_ERROR;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_BLKIO, "NorFlashWriteSingleBlock: Erasing block %ld to write 0x%x bytes at 0x%x\n", Lba, *NumBytes, Offset));
+
   // Read NOR Flash data into shadow buffer
   TempStatus = NorFlashReadBlocks (Instance, Lba, BlockSize, Instance->ShadowBuffer);
   if (EFI_ERROR (TempStatus)) {
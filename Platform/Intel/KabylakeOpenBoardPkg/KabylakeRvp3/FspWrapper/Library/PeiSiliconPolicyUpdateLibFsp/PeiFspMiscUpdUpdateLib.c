@@ -50,7 +50,7 @@ PeiFspMiscUpdUpdatePreMem (
   //
   FspNvsBufferPtr   = NULL;
   VariableSize  = 0;
-  Status = PeiGetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &FspNvsBufferPtr, &VariableSize);
+  Status = PeiGetFspNvsBuffer (&FspNvsBufferPtr, &VariableSize);
   if (Status == EFI_SUCCESS) {
     DEBUG ((DEBUG_INFO, "Get L\"FspNvsBuffer\" gFspNvsBufferVariableGuid - %r\n", Status));
     DEBUG ((DEBUG_INFO, "FspNvsBuffer Size - 0x%x\n", VariableSize));
@@ -17,10 +17,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/GlobalVariable.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/CompressLib.h>
 #include <Library/LargeVariableReadLib.h>
 #include <Library/LargeVariableWriteLib.h>
 #include <Library/VariableWriteLib.h>
 #include <Guid/FspNonVolatileStorageHob2.h>
+#include <FspNvsBufferCompressed.h>
 
 /**
   This is the standard EFI driver point that detects whether there is a
@@ -42,13 +45,17 @@ SaveMemoryConfigEntryPoint (
   EFI_HOB_GUID_TYPE *GuidHob;
   VOID              *HobData;
   VOID              *VariableData;
+  VOID              *CompressedData;
   UINTN             DataSize;
   UINTN             BufferSize;
+  UINT64            CompressedSize;
   BOOLEAN           DataIsIdentical;
+  FSP_NVS_BUFFER_COMPRESSED_HEADER  *CompressedHeader;
 
   DataSize        = 0;
   BufferSize      = 0;
   VariableData    = NULL;
+  CompressedData  = NULL;
   GuidHob         = NULL;
   HobData         = NULL;
   DataIsIdentical = FALSE;
@@ -76,6 +83,40 @@ SaveMemoryConfigEntryPoint (
   if (HobData != NULL) {
     DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataLength:%d\n", DataSize));
     DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataPtr   : 0x%x\n", HobData));
+    if ((DataSize > 0) && FeaturePcdGet (PcdFspNvsBufferCompressionEnable)) {
+      //
+      // Save the data compressed behind a FSP_NVS_BUFFER_COMPRESSED_HEADER,
+      // PeiGetFspNvsBuffer() decompresses it. Compress() returns the size it
+      // needs if the first guess is too small.
+      //
+      CompressedSize = DataSize;
+      CompressedData = AllocatePool (sizeof (*CompressedHeader) + (UINTN) CompressedSize);
+      Status = EFI_OUT_OF_RESOURCES;
+      if (CompressedData != NULL) {
+        Status = Compress (HobData, DataSize, (UINT8 *) CompressedData + sizeof (*CompressedHeader), &CompressedSize);
+        if (Status == EFI_BUFFER_TOO_SMALL) {
+          FreePool (CompressedData);
+          CompressedData = AllocatePool (sizeof (*CompressedHeader) + (UINTN) CompressedSize);
+          Status = EFI_OUT_OF_RESOURCES;
+          if (CompressedData != NULL) {
+            Status = Compress (HobData, DataSize, (UINT8 *) CompressedData + sizeof (*CompressedHeader), &CompressedSize);
+          }
+        }
+      }
+      if (!EFI_ERROR (Status)) {
+        CompressedHeader                   = CompressedData;
+        CompressedHeader->Signature        = FSP_NVS_BUFFER_COMPRESSED_SIGNATURE;
+        CompressedHeader->CompressedSize   = (UINT32) CompressedSize;
+        CompressedHeader->DecompressedSize = (UINT32) DataSize;
+        CompressedHeader->Reserved         = 0;
+        DEBUG ((DEBUG_INFO, "FSP / MRC Training Data compressed from 0x%x to 0x%lx bytes\n", DataSize, CompressedSize));
+        HobData  = CompressedData;
+        DataSize = sizeof (*CompressedHeader) + (UINTN) CompressedSize;
+      } else {
+        DEBUG ((DEBUG_ERROR, "Failed to compress FSP / MRC Training Data, saving it uncompressed: %r\n", Status));
+      }
+    }
+
     if (DataSize > 0) {
       //
       // Check if the presently saved data is identical to the data given by MRC/FSP
@@ -132,6 +173,10 @@ SaveMemoryConfigEntryPoint (
         DEBUG ((DEBUG_INFO, "FSP / MRC Training Data is identical to data from last boot, no need to save.\n"));
       }
     }
+
+    if (CompressedData != NULL) {
+      FreePool (CompressedData);
+    }
   } else {
     DEBUG((DEBUG_ERROR, "Memory S3 Data HOB was not found\n"));
   }
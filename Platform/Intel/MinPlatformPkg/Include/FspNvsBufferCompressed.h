@@ -0,0 +1,26 @@
+/** @file
+  Header file for the compressed FSP Non-Volatile Storage data layout.
+
+Copyright (c) 2022, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FSP_NVS_BUFFER_COMPRESSED_H__
+#define __FSP_NVS_BUFFER_COMPRESSED_H__
+
+//
+// When PcdFspNvsBufferCompressionEnable is TRUE, SaveMemoryConfig stores the
+// FSP Non-Volatile Storage data in the FspNvsBuffer variable as this header,
+// followed by the data compressed with CompressLib.
+//
+#define FSP_NVS_BUFFER_COMPRESSED_SIGNATURE  SIGNATURE_32 ('F', 'N', 'V', 'C')
+
+typedef struct {
+  UINT32  Signature;
+  UINT32  CompressedSize;
+  UINT32  DecompressedSize;
+  UINT32  Reserved;
+} FSP_NVS_BUFFER_COMPRESSED_HEADER;
+
+#endif
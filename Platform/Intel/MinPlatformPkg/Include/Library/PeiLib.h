@@ -68,6 +68,32 @@ PeiGetLargeVariable (
   OUT UINTN     *Size  OPTIONAL
   );
 
+/**
+  This function returns the FSP Non-Volatile Storage data saved by
+  SaveMemoryConfig in the FspNvsBuffer large variable. If
+  PcdFspNvsBufferCompressionEnable is TRUE and the data was stored compressed,
+  it is decompressed.
+  The function uses AllocatePages () to allocate the buffer.
+  The caller is responsible for freeing this buffer with FreePages().
+
+  If Value is NULL, then ASSERT().
+
+  @param[out] Value The buffer point saved the FSP Non-Volatile Storage data.
+  @param[out] Size  The size of the FSP Non-Volatile Storage data.
+
+  @return EFI_OUT_OF_RESOURCES      Allocate buffer failed.
+  @return EFI_VOLUME_CORRUPTED      The compressed data could not be decompressed.
+  @return EFI_SUCCESS               Find the FSP Non-Volatile Storage data.
+  @return Others Errors             Return errors from call to PeiGetLargeVariable().
+
+**/
+EFI_STATUS
+EFIAPI
+PeiGetFspNvsBuffer (
+  OUT VOID      **Value,
+  OUT UINTN     *Size  OPTIONAL
+  );
+
 /**
   Finds the file in any FV and gets file Address and Size
 
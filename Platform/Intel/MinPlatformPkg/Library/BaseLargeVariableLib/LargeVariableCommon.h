@@ -51,4 +51,24 @@
 //
 #define MAX_VARIABLE_NAME_PAD_SIZE  3
 
+//
+// When more than one variable is needed, a manifest is also stored in a
+// variable named with this suffix added to the variable name. It gives the
+// number of variables and the total size of the data, so that the data can be
+// read with one lookup per variable instead of first probing all of them for
+// their size. Data sets stored without a manifest are still read by probing.
+//
+// The suffix is no longer than MAX_VARIABLE_SPLIT_DIGITS, so the variable name
+// length checks made for the split variables also cover the manifest.
+//
+#define LARGE_VARIABLE_MANIFEST_SUFFIX     L"Info"
+
+#define LARGE_VARIABLE_MANIFEST_SIGNATURE  SIGNATURE_32 ('L', 'V', 'M', 'F')
+
+typedef struct {
+  UINT32  Signature;
+  UINT32  VariableCount;
+  UINT64  TotalSize;
+} LARGE_VARIABLE_MANIFEST;
+
 #endif  // _LARGE_VARIABLE_COMMON_H_
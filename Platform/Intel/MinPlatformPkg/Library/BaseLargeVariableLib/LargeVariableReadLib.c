@@ -24,6 +24,129 @@
 
 #include "LargeVariableCommon.h"
 
+/**
+  Returns the value of a large variable stored in multiple variables, using the
+  manifest written by SetLargeVariable() to know which variables hold the data.
+
+  @param[in]       VariableName  A Null-terminated string that is the name of the vendor's
+                                 variable.
+  @param[in]       VendorGuid    A unique identifier for the vendor.
+  @param[in, out]  DataSize      On input, the size in bytes of the return Data buffer.
+                                 On output the size of data returned in Data.
+  @param[out]      Data          The buffer to return the contents of the variable. May be NULL
+                                 with a zero DataSize in order to determine the size buffer needed.
+
+  @retval EFI_SUCCESS            The function completed successfully.
+  @retval EFI_NOT_FOUND          There is no manifest, or it does not match the stored variables.
+  @retval EFI_BUFFER_TOO_SMALL   The DataSize is too small for the result.
+  @retval EFI_INVALID_PARAMETER  The DataSize is not too small and Data is NULL.
+
+**/
+STATIC
+EFI_STATUS
+GetLargeVariableFromManifest (
+  IN     CHAR16                      *VariableName,
+  IN     EFI_GUID                    *VendorGuid,
+  IN OUT UINTN                       *DataSize,
+  OUT    VOID                        *Data           OPTIONAL
+  )
+{
+  CHAR16                    TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  LARGE_VARIABLE_MANIFEST   Manifest;
+  EFI_STATUS                Status;
+  UINTN                     ManifestSize;
+  UINTN                     Index;
+  UINTN                     VariableSize;
+  UINTN                     BytesRemaining;
+  UINT64                    StoredSize;
+  UINT8                     *OffsetPtr;
+
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_MANIFEST_SUFFIX);
+  ManifestSize = sizeof (Manifest);
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &ManifestSize, &Manifest);
+  if (EFI_ERROR (Status) ||
+      (ManifestSize != sizeof (Manifest)) ||
+      (Manifest.Signature != LARGE_VARIABLE_MANIFEST_SIGNATURE) ||
+      (Manifest.VariableCount == 0) ||
+      (Manifest.VariableCount > MAX_VARIABLE_SPLIT) ||
+      (Manifest.TotalSize > MAX_UINTN)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Check the manifest against the stored variables before its size is
+  // reported, so that a stale manifest falls back to probing instead of
+  // returning the wrong size for a query with a NULL buffer.
+  //
+  StoredSize = 0;
+  for (Index = 0; Index < Manifest.VariableCount; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    VariableSize = 0;
+    Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
+    if (Status != EFI_BUFFER_TOO_SMALL) {
+      DEBUG ((DEBUG_WARN, "GetLargeVariable: Reading %s failed, Status = %r, ignoring manifest\n", TempVariableName, Status));
+      return EFI_NOT_FOUND;
+    }
+    StoredSize += VariableSize;
+  }
+
+  if (StoredSize != Manifest.TotalSize) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: Stored size does not match the manifest, ignoring manifest\n"));
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // SetLargeVariable() writes the manifest after the variables. If it was
+  // interrupted while the data set was growing, the old manifest can still
+  // add up, so make sure that no variable follows the last one it lists.
+  //
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+  VariableSize = 0;
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
+  if (Status != EFI_NOT_FOUND) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: %s is not in the manifest, ignoring manifest\n", TempVariableName));
+    return EFI_NOT_FOUND;
+  }
+
+  if (*DataSize < (UINTN) Manifest.TotalSize) {
+    *DataSize = (UINTN) Manifest.TotalSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+  if (Data == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Read the data from all variables
+  //
+  OffsetPtr       = (UINT8 *) Data;
+  BytesRemaining  = (UINTN) Manifest.TotalSize;
+  for (Index = 0; Index < Manifest.VariableCount; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    VariableSize = BytesRemaining;
+    Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, (VOID *) OffsetPtr);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "GetLargeVariable: Reading %s failed, Status = %r, ignoring manifest\n", TempVariableName, Status));
+      return EFI_NOT_FOUND;
+    }
+    BytesRemaining -= VariableSize;
+    OffsetPtr += VariableSize;
+  }
+
+  if (BytesRemaining != 0) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: %d bytes missing, ignoring manifest\n", BytesRemaining));
+    return EFI_NOT_FOUND;
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "GetLargeVariable: Read %d bytes from %d variables\n", (UINTN) Manifest.TotalSize, Manifest.VariableCount));
+  *DataSize = (UINTN) Manifest.TotalSize;
+  return EFI_SUCCESS;
+}
+
 /**
   Returns the value of a large variable.
 
@@ -95,6 +218,15 @@ GetLargeVariable (
       goto Done;
     }
 
+    //
+    // If the variables were saved with a manifest, there is no need to probe
+    // all of them for their size.
+    //
+    Status = GetLargeVariableFromManifest (VariableName, VendorGuid, DataSize, Data);
+    if (Status != EFI_NOT_FOUND) {
+      goto Done;
+    }
+
     VarDataSize = 0;
     Index       = 0;
     ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
@@ -19,6 +19,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/VariableReadLib.h>
 #include <Library/VariableWriteLib.h>
@@ -118,6 +119,131 @@ GetVariableSplitSize (
   return VariableSplitSize;
 }
 
+/**
+  Checks if a variable already holds the given data, so that writing it again
+  can be skipped.
+
+  If a buffer to read back the variable cannot be allocated, FALSE is returned
+  and the caller simply writes the data.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  DataSize           The size in bytes of the Data buffer.
+  @param[in]  Data               The data to compare the variable with.
+
+  @retval TRUE                   The variable exists and its contents are identical to Data.
+  @retval FALSE                  The variable does not exist, or its contents differ from Data.
+
+**/
+STATIC
+BOOLEAN
+IsVariableDataIdentical (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  UINTN                        DataSize,
+  IN  VOID                         *Data
+  )
+{
+  EFI_STATUS    Status;
+  UINTN         VarDataSize;
+  VOID          *VarData;
+  BOOLEAN       Identical;
+
+  VarDataSize = 0;
+  Status = VarLibGetVariable (VariableName, VendorGuid, NULL, &VarDataSize, NULL);
+  if ((Status != EFI_BUFFER_TOO_SMALL) || (VarDataSize != DataSize)) {
+    return FALSE;
+  }
+
+  VarData = AllocatePool (VarDataSize);
+  if (VarData == NULL) {
+    return FALSE;
+  }
+
+  Identical = FALSE;
+  Status = VarLibGetVariable (VariableName, VendorGuid, NULL, &VarDataSize, VarData);
+  if (!EFI_ERROR (Status) && (VarDataSize == DataSize) && (CompareMem (VarData, Data, DataSize) == 0)) {
+    Identical = TRUE;
+  }
+
+  FreePool (VarData);
+  return Identical;
+}
+
+/**
+  Deletes the variables "<VariableName><Index>" of a multi-variable set,
+  starting at StartIndex and stopping at the first one that does not exist.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+                                 Its length must have been checked to leave room for the index.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  StartIndex         Index of the first variable to delete.
+
+**/
+STATIC
+VOID
+DeleteLargeVariableChunks (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  UINTN                        StartIndex
+  )
+{
+  CHAR16        TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  EFI_STATUS    Status;
+  UINTN         Index;
+
+  for (Index = StartIndex; Index < MAX_VARIABLE_SPLIT; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    Status = VarLibSetVariable (
+               TempVariableName,
+               VendorGuid,
+               EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+               0,
+               NULL
+               );
+    if (EFI_ERROR (Status)) {
+      if (Status != EFI_NOT_FOUND) {
+        DEBUG ((DEBUG_ERROR, "DeleteLargeVariableChunks: Error deleting %s: Status = %r\n", TempVariableName, Status));
+      }
+      break;
+    }
+    DEBUG ((DEBUG_INFO, "Deleted stale %s, Guid = %g\n", TempVariableName, VendorGuid));
+  }
+}
+
+/**
+  Deletes the manifest of a multi-variable set, if there is one.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+                                 Its length must have been checked to leave room for the suffix.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+
+**/
+STATIC
+VOID
+DeleteLargeVariableManifest (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid
+  )
+{
+  CHAR16        TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  EFI_STATUS    Status;
+
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_MANIFEST_SUFFIX);
+  Status = VarLibSetVariable (
+             TempVariableName,
+             VendorGuid,
+             EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+             0,
+             NULL
+             );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    DEBUG ((DEBUG_ERROR, "DeleteLargeVariableManifest: Error deleting %s: Status = %r\n", TempVariableName, Status));
+  }
+}
+
 /**
   Deletes a large variable.
 
@@ -210,6 +336,7 @@ DeleteLargeVariableInternal (
           Status = Status2;
         }
       }   // End of for loop
+      DeleteLargeVariableManifest (VariableName, VendorGuid);
     } else {
       Status = EFI_NOT_FOUND;
     }
@@ -270,6 +397,8 @@ SetLargeVariable (
   UINT8         *OffsetPtr;
   UINTN         BytesRemaining;
   UINTN         SizeToSave;
+  UINTN         BytesWritten;
+  LARGE_VARIABLE_MANIFEST  Manifest;
 
   //
   // Check input parameters.
@@ -288,6 +417,7 @@ SetLargeVariable (
   }
 
   VariablesSaved = 0;
+  BytesWritten   = 0;
   if (LockVariable && !VarLibIsVariableRequestToLockSupported ()) {
       Status = EFI_INVALID_PARAMETER;
       DEBUG ((DEBUG_ERROR, "SetLargeVariable: Variable locking is not currently supported\n"));
@@ -321,6 +451,17 @@ SetLargeVariable (
     if (EFI_ERROR (Status)) {
       goto Done;
     }
+    BytesWritten = DataSize;
+
+    //
+    // Remove the variables of a multi-variable set left over from a previous,
+    // larger data set.
+    //
+    if (VariableNameLength < (MAX_VARIABLE_NAME_SIZE - MAX_VARIABLE_SPLIT_DIGITS)) {
+      DeleteLargeVariableChunks (VariableName, VendorGuid, 0);
+      DeleteLargeVariableManifest (VariableName, VendorGuid);
+    }
+
     if (LockVariable) {
       Status = VarLibVariableRequestToLock (VariableName, VendorGuid);
       if (EFI_ERROR (Status)) {
@@ -372,6 +513,23 @@ SetLargeVariable (
     }
 
     DEBUG ((DEBUG_VERBOSE, "SetLargeVariable: Saving using multiple variables.\n"));
+
+    //
+    // A single variable left over from a previous, smaller data set would be
+    // found before the multi-variable set by GetLargeVariable(), remove it.
+    //
+    Status = VarLibSetVariable (
+               VariableName,
+               VendorGuid,
+               EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+               0,
+               NULL
+               );
+    if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+      DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting single variable: Status = %r\n", Status));
+      goto Done;
+    }
+
     OffsetPtr         = (UINT8 *) Data;
     BytesRemaining    = DataSize;
     VariablesSaved    = 0;
@@ -397,22 +555,61 @@ SetLargeVariable (
       } else {
         SizeToSave = BytesRemaining;
       }
-      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
+      //
+      // Only rewrite the variables whose part of the data has changed, so that
+      // a small change to a large data set does not rewrite all of it.
+      //
+      if (IsVariableDataIdentical (TempVariableName, VendorGuid, SizeToSave, OffsetPtr)) {
+        DEBUG ((DEBUG_INFO, "Keeping %s, Guid = %g, Size %d, data is unchanged\n", TempVariableName, VendorGuid, SizeToSave));
+      } else {
+        DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
+        Status = VarLibSetVariable (
+                  TempVariableName,
+                  VendorGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                  SizeToSave,
+                  (VOID *) OffsetPtr
+                  );
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
+          goto Done;
+        }
+        BytesWritten += SizeToSave;
+      }
+      VariablesSaved++;
+      BytesRemaining -= SizeToSave;
+      OffsetPtr += SizeToSave;
+    }   // End of for loop
+
+    //
+    // Remove the variables left over from a previous, larger data set.
+    //
+    DeleteLargeVariableChunks (VariableName, VendorGuid, VariablesSaved);
+
+    //
+    // Save the manifest last, GetLargeVariable() ignores it if it does not
+    // match the variables that are actually stored.
+    //
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_MANIFEST_SUFFIX);
+    Manifest.Signature     = LARGE_VARIABLE_MANIFEST_SIGNATURE;
+    Manifest.VariableCount = (UINT32) VariablesSaved;
+    Manifest.TotalSize     = DataSize;
+    if (!IsVariableDataIdentical (TempVariableName, VendorGuid, sizeof (Manifest), &Manifest)) {
+      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, %d variables\n", TempVariableName, VendorGuid, VariablesSaved));
       Status = VarLibSetVariable (
                 TempVariableName,
                 VendorGuid,
                 EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                SizeToSave,
-                (VOID *) OffsetPtr
+                sizeof (Manifest),
+                &Manifest
                 );
       if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
+        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting manifest: Status = %r\n", Status));
         goto Done;
       }
-      VariablesSaved++;
-      BytesRemaining -= SizeToSave;
-      OffsetPtr += SizeToSave;
-    }   // End of for loop
+      BytesWritten += sizeof (Manifest);
+    }
 
     //
     // If the user requested that the variables be locked, lock them now that
@@ -435,6 +632,17 @@ SetLargeVariable (
           goto Done;
         }
       }
+
+      ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+      UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_MANIFEST_SUFFIX);
+      DEBUG ((DEBUG_INFO, "Locking %s, Guid = %g\n", TempVariableName, VendorGuid));
+      Status = VarLibVariableRequestToLock (TempVariableName, VendorGuid);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error locking manifest: Status = %r\n", Status));
+        Status = EFI_ABORTED;
+        VariablesSaved = 0;
+        goto Done;
+      }
     }
   }
 
@@ -457,6 +665,10 @@ Done:
         DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting variable: Status = %r\n", Status2));
       }
     }
+    DeleteLargeVariableManifest (VariableName, VendorGuid);
+  }
+  if (!EFI_ERROR (Status) && (DataSize != 0)) {
+    DEBUG ((DEBUG_INFO, "SetLargeVariable: %d of %d bytes written\n", BytesWritten, DataSize));
   }
   DEBUG ((DEBUG_ERROR, "SetLargeVariable: Status = %r\n", Status));
   return Status;
@@ -568,8 +780,20 @@ LockLargeVariable (
           }
         } else if (Status == EFI_NOT_FOUND) {
           //
-          // No more variables need to lock.
+          // No more variables need to lock, only the manifest if there is one.
           //
+          ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+          UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_MANIFEST_SUFFIX);
+          VariableSize = 0;
+          Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
+          if (Status == EFI_BUFFER_TOO_SMALL) {
+            DEBUG ((DEBUG_INFO, "Locking %s, Guid = %g\n", TempVariableName, VendorGuid));
+            Status = VarLibVariableRequestToLock (TempVariableName, VendorGuid);
+            if (EFI_ERROR (Status)) {
+              DEBUG ((DEBUG_ERROR, "LockLargeVariable: Failed! Satus = %r\n", Status));
+              return EFI_ABORTED;
+            }
+          }
           return EFI_SUCCESS;
         }
       }   // End of for loop
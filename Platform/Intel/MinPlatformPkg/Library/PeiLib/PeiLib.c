@@ -10,7 +10,10 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/PeiServicesLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/LargeVariableReadLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UefiDecompressLib.h>
 #include <Ppi/ReadOnlyVariable2.h>
+#include <FspNvsBufferCompressed.h>
 
 /**
   Returns the status whether get the variable success. The function retrieves
@@ -177,6 +180,110 @@ PeiGetLargeVariable (
   return Status;
 }
 
+/**
+  This function returns the FSP Non-Volatile Storage data saved by
+  SaveMemoryConfig in the FspNvsBuffer large variable. If
+  PcdFspNvsBufferCompressionEnable is TRUE and the data was stored compressed,
+  it is decompressed.
+  The function uses AllocatePages () to allocate the buffer.
+  The caller is responsible for freeing this buffer with FreePages().
+
+  If Value is NULL, then ASSERT().
+
+  @param[out] Value The buffer point saved the FSP Non-Volatile Storage data.
+  @param[out] Size  The size of the FSP Non-Volatile Storage data.
+
+  @return EFI_OUT_OF_RESOURCES      Allocate buffer failed.
+  @return EFI_VOLUME_CORRUPTED      The compressed data could not be decompressed.
+  @return EFI_SUCCESS               Find the FSP Non-Volatile Storage data.
+  @return Others Errors             Return errors from call to PeiGetLargeVariable().
+
+**/
+EFI_STATUS
+EFIAPI
+PeiGetFspNvsBuffer (
+  OUT VOID      **Value,
+  OUT UINTN     *Size  OPTIONAL
+  )
+{
+  EFI_STATUS                        Status;
+  VOID                              *StoredData;
+  UINTN                             StoredSize;
+  FSP_NVS_BUFFER_COMPRESSED_HEADER  *CompressedHeader;
+  VOID                              *Data;
+  UINT32                            DataSize;
+  VOID                              *Scratch;
+  UINT32                            ScratchSize;
+
+  ASSERT (Value != NULL);
+
+  StoredData = NULL;
+  StoredSize = 0;
+  Status = PeiGetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &StoredData, &StoredSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Data saved before compression was enabled has no compressed data header,
+  // return it as is.
+  //
+  CompressedHeader = StoredData;
+  if (!FeaturePcdGet (PcdFspNvsBufferCompressionEnable) ||
+      (StoredSize < sizeof (*CompressedHeader)) ||
+      (CompressedHeader->Signature != FSP_NVS_BUFFER_COMPRESSED_SIGNATURE) ||
+      (CompressedHeader->CompressedSize != StoredSize - sizeof (*CompressedHeader))) {
+    *Value = StoredData;
+    if (Size != NULL) {
+      *Size = StoredSize;
+    }
+    return EFI_SUCCESS;
+  }
+
+  Status = UefiDecompressGetInfo (
+             CompressedHeader + 1,
+             CompressedHeader->CompressedSize,
+             &DataSize,
+             &ScratchSize
+             );
+  if (EFI_ERROR (Status) || (DataSize != CompressedHeader->DecompressedSize)) {
+    DEBUG ((DEBUG_ERROR, "Error: FspNvsBuffer compressed data is corrupted\n"));
+    FreePages (StoredData, EFI_SIZE_TO_PAGES (StoredSize));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Data    = AllocatePages (EFI_SIZE_TO_PAGES (DataSize));
+  Scratch = AllocatePool (ScratchSize);
+  if ((Data == NULL) || (Scratch == NULL)) {
+    DEBUG ((DEBUG_ERROR, "Error: Cannot decompress FspNvsBuffer, out of memory!\n"));
+    ASSERT (FALSE);
+    if (Data != NULL) {
+      FreePages (Data, EFI_SIZE_TO_PAGES (DataSize));
+    }
+    if (Scratch != NULL) {
+      FreePool (Scratch);
+    }
+    FreePages (StoredData, EFI_SIZE_TO_PAGES (StoredSize));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = UefiDecompress (CompressedHeader + 1, Data, Scratch);
+  FreePool (Scratch);
+  FreePages (StoredData, EFI_SIZE_TO_PAGES (StoredSize));
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Error: Unable to decompress FspNvsBuffer Status: %r\n", Status));
+    FreePages (Data, EFI_SIZE_TO_PAGES (DataSize));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  DEBUG ((DEBUG_INFO, "FspNvsBuffer decompressed from 0x%x to 0x%x bytes\n", StoredSize, DataSize));
+  *Value = Data;
+  if (Size != NULL) {
+    *Size = DataSize;
+  }
+  return EFI_SUCCESS;
+}
+
 EFI_PEI_FILE_HANDLE
 InternalGetFfsHandleFromAnyFv (
   IN CONST  EFI_GUID           *NameGuid
@@ -106,7 +106,7 @@ SiliconPolicyDonePreMem(
   //
   FspNvsBufferPtr   = NULL;
   FspNvsBufferSize  = 0;
-  Status = PeiGetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &FspNvsBufferPtr, &FspNvsBufferSize);
+  Status = PeiGetFspNvsBuffer (&FspNvsBufferPtr, &FspNvsBufferSize);
   if (Status == EFI_SUCCESS) {
     DEBUG ((DEBUG_INFO, "Get L\"FspNvsBuffer\" gFspNvsBufferVariableGuid - %r\n", Status));
     DEBUG ((DEBUG_INFO, "FspNvsBuffer Size - 0x%x\n", FspNvsBufferSize));
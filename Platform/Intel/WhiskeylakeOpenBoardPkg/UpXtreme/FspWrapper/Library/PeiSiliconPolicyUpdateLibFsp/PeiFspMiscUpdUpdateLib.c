@@ -49,7 +49,7 @@ PeiFspMiscUpdUpdatePreMem (
 
   FspNvsBufferPtr   = NULL;
   FspNvsBufferSize  = 0;
-  Status = PeiGetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &FspNvsBufferPtr, &FspNvsBufferSize);
+  Status = PeiGetFspNvsBuffer (&FspNvsBufferPtr, &FspNvsBufferSize);
   if (Status == EFI_SUCCESS) {
     FspmUpd->FspmArchUpd.NvsBufferPtr = FspNvsBufferPtr;
   } else {
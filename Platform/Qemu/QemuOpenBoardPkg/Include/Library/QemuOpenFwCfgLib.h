@@ -29,6 +29,20 @@
 
 #define FW_CFG_QEMU_SIGNATURE SIGNATURE_32('Q', 'E', 'M', 'U')
 
+// "QEMU CFG", as read from the two halves of the DMA address register
+#define FW_CFG_DMA_SIGNATURE_HIGH  SIGNATURE_32('Q', 'E', 'M', 'U')
+#define FW_CFG_DMA_SIGNATURE_LOW   SIGNATURE_32(' ', 'C', 'F', 'G')
+
+// DMA control bits
+#define FW_CFG_DMA_CTL_ERROR   BIT0
+#define FW_CFG_DMA_CTL_READ    BIT1
+#define FW_CFG_DMA_CTL_SKIP    BIT2
+#define FW_CFG_DMA_CTL_SELECT  BIT3
+#define FW_CFG_DMA_CTL_WRITE   BIT4
+
+// Transfers smaller than this are done one byte at a time through FW_CFG_PORT_DATA
+#define FW_CFG_DMA_MIN_SIZE  8
+
 typedef struct {
   UINT32    Size;
   UINT16    Select;
@@ -36,6 +50,15 @@ typedef struct {
   CHAR8     Name[56];
 } QEMU_FW_CFG_FILE;
 
+// DMA access descriptor, all fields are big-endian
+#pragma pack (1)
+typedef struct {
+  UINT32    Control;
+  UINT32    Length;
+  UINT64    Address;
+} QEMU_FW_CFG_DMA_ACCESS;
+#pragma pack ()
+
 /**
   Checks for Qemu fw_cfg device by reading "QEMU" using the signature selector
 
@@ -48,6 +71,20 @@ QemuFwCfgIsPresent (
   VOID
   );
 
+/**
+  Checks if the fw_cfg device supports the DMA interface, by reading the
+  signature of its DMA address register. This does not change the selected
+  item or its read offset.
+
+  @return TRUE  - DMA transfers are supported
+  @return FALSE - Only the data register can be used
+ */
+BOOLEAN
+EFIAPI
+QemuFwCfgIsDmaSupported (
+  VOID
+  );
+
 /**
  Sets the selector register to the specified value
 
@@ -86,6 +123,36 @@ QemuFwCfgReadBytes (
   OUT VOID  *Buffer
   );
 
+/**
+  Skips N bytes of the selected item
+
+  @param[in] Size Number of bytes to skip
+ */
+VOID
+EFIAPI
+QemuFwCfgSkipBytes (
+  IN UINTN  Size
+  );
+
+/**
+  Selects an item and reads N bytes from its start
+
+  @param[in]  Selector Item to read
+  @param[in]  Size     Number of bytes to read
+  @param[out] Buffer   Buffer for the data
+
+  @return EFI_SUCCESS
+  @return EFI_UNSUPPORTED The item could not be selected
+  @return EFI_DEVICE_ERROR The DMA transfer failed
+ */
+EFI_STATUS
+EFIAPI
+QemuFwCfgReadItem (
+  IN  UINT16  Selector,
+  IN  UINTN   Size,
+  OUT VOID    *Buffer
+  );
+
 /**
   Finds a file in fw_cfg by its name
 
@@ -11,9 +11,13 @@
 **/
 
 #include <Library/QemuOpenFwCfgLib.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 
+// Number of directory entries read at once by QemuFwCfgFindFile
+#define FW_CFG_FILE_DIR_BATCH  8
+
 /**
   Reads 8 bits from the data register.
 
@@ -28,6 +32,87 @@ QemuFwCfgRead8 (
   return IoRead8 (FW_CFG_PORT_DATA);
 }
 
+/**
+  Checks if the fw_cfg device supports the DMA interface, by reading the
+  signature of its DMA address register. This does not change the selected
+  item or its read offset.
+
+  @retval TRUE  DMA transfers are supported
+  @retval FALSE Only the data register can be used
+**/
+BOOLEAN
+EFIAPI
+QemuFwCfgIsDmaSupported (
+  VOID
+  )
+{
+  return (BOOLEAN)((IoRead32 (FW_CFG_PORT_DMA) == FW_CFG_DMA_SIGNATURE_HIGH) &&
+                   (IoRead32 (FW_CFG_PORT_DMA + 4) == FW_CFG_DMA_SIGNATURE_LOW));
+}
+
+/**
+  Runs a DMA transfer and waits for it to complete.
+
+  The descriptor lives on the stack, which is ordinary RAM on QEMU even
+  before permanent memory is installed.
+
+  @param Control FW_CFG_DMA_CTL_* bits, with the selector in the upper 16 bits
+                 if FW_CFG_DMA_CTL_SELECT is set
+  @param Size    Number of bytes to transfer
+  @param Buffer  Data buffer, or NULL for FW_CFG_DMA_CTL_SKIP
+
+  @retval EFI_SUCCESS
+  @retval EFI_DEVICE_ERROR The device failed the transfer
+**/
+STATIC
+EFI_STATUS
+QemuFwCfgDmaTransfer (
+  IN UINT32  Control,
+  IN UINTN   Size,
+  IN VOID    *Buffer
+  )
+{
+  volatile QEMU_FW_CFG_DMA_ACCESS  Access;
+  UINT64                           AccessAddress;
+  UINT32                           Length;
+  UINT32                           Result;
+
+  do {
+    Length = (UINT32)MIN (Size, MAX_UINT32);
+
+    Access.Control = SwapBytes32 (Control);
+    Access.Length  = SwapBytes32 (Length);
+    Access.Address = SwapBytes64 ((UINT64)(UINTN)Buffer);
+
+    // The descriptor must be visible to the device before the transfer starts
+    MemoryFence ();
+
+    // Writing the low half of the address starts the transfer
+    AccessAddress = (UINT64)(UINTN)&Access;
+    IoWrite32 (FW_CFG_PORT_DMA, SwapBytes32 ((UINT32)RShiftU64 (AccessAddress, 32)));
+    IoWrite32 (FW_CFG_PORT_DMA + 4, SwapBytes32 ((UINT32)AccessAddress));
+
+    do {
+      Result = SwapBytes32 (Access.Control);
+    } while ((Result & ~FW_CFG_DMA_CTL_ERROR) != 0);
+
+    MemoryFence ();
+
+    if ((Result & FW_CFG_DMA_CTL_ERROR) != 0) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    // Only the first transfer selects the item, the rest continue from where it stopped
+    Control &= ~(FW_CFG_DMA_CTL_SELECT | 0xFFFF0000);
+    Size    -= Length;
+    if (Buffer != NULL) {
+      Buffer = (UINT8 *)Buffer + Length;
+    }
+  } while (Size > 0);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Sets the selector register to the specified value
 
@@ -66,9 +151,82 @@ QemuFwCfgReadBytes (
   OUT VOID  *Buffer
   )
 {
+  EFI_STATUS  Status;
+
+  // Every byte read through the data register is a VM exit
+  if ((Size >= FW_CFG_DMA_MIN_SIZE) && QemuFwCfgIsDmaSupported ()) {
+    Status = QemuFwCfgDmaTransfer (FW_CFG_DMA_CTL_READ, Size, Buffer);
+    ASSERT_EFI_ERROR (Status);
+    return;
+  }
+
   IoReadFifo8 (FW_CFG_PORT_DATA, Size, Buffer);
 }
 
+/**
+  Skips N bytes of the selected item
+
+  @param Size
+**/
+VOID
+EFIAPI
+QemuFwCfgSkipBytes (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Size >= FW_CFG_DMA_MIN_SIZE) && QemuFwCfgIsDmaSupported ()) {
+    Status = QemuFwCfgDmaTransfer (FW_CFG_DMA_CTL_SKIP, Size, NULL);
+    ASSERT_EFI_ERROR (Status);
+    return;
+  }
+
+  while (Size-- > 0) {
+    IoRead8 (FW_CFG_PORT_DATA);
+  }
+}
+
+/**
+  Selects an item and reads N bytes from its start
+
+  @param Selector
+  @param Size
+  @param Buffer
+
+  @retval EFI_SUCCESS
+  @retval EFI_UNSUPPORTED
+  @retval EFI_DEVICE_ERROR
+**/
+EFI_STATUS
+EFIAPI
+QemuFwCfgReadItem (
+  IN  UINT16  Selector,
+  IN  UINTN   Size,
+  OUT VOID    *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Size >= FW_CFG_DMA_MIN_SIZE) && QemuFwCfgIsDmaSupported ()) {
+    Status = QemuFwCfgDmaTransfer (
+               FW_CFG_DMA_CTL_SELECT | FW_CFG_DMA_CTL_READ | ((UINT32)Selector << 16),
+               Size,
+               Buffer
+               );
+    ASSERT_EFI_ERROR (Status);
+    return Status;
+  }
+
+  Status = QemuFwCfgSelectItem (Selector);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  IoReadFifo8 (FW_CFG_PORT_DATA, Size, Buffer);
+  return EFI_SUCCESS;
+}
+
 /**
   Checks for Qemu fw_cfg device by reading "QEMU" using the signature selector
 
@@ -113,22 +271,30 @@ QemuFwCfgFindFile (
   OUT QEMU_FW_CFG_FILE  *FWConfigFile
   )
 {
-  QEMU_FW_CFG_FILE  FirmwareConfigFile;
+  QEMU_FW_CFG_FILE  FirmwareConfigFiles[FW_CFG_FILE_DIR_BATCH];
+  QEMU_FW_CFG_FILE  *FirmwareConfigFile;
   UINT32            FilesCount;
+  UINT32            BatchCount;
   UINT32            Idx;
+  UINT32            BatchIdx;
 
-  QemuFwCfgSelectItem (FW_CFG_FILE_DIR);
-  QemuFwCfgReadBytes (sizeof (UINT32), &FilesCount);
+  QemuFwCfgReadItem (FW_CFG_FILE_DIR, sizeof (UINT32), &FilesCount);
 
   FilesCount = SwapBytes32 (FilesCount);
 
-  for (Idx = 0; Idx < FilesCount; Idx++) {
-    QemuFwCfgReadBytes (sizeof (QEMU_FW_CFG_FILE), &FirmwareConfigFile);
-    if (AsciiStrCmp ((CHAR8 *)&(FirmwareConfigFile.Name), String) == 0) {
-      FirmwareConfigFile.Select = SwapBytes16 (FirmwareConfigFile.Select);
-      FirmwareConfigFile.Size   = SwapBytes32 (FirmwareConfigFile.Size);
-      CopyMem (FWConfigFile, &FirmwareConfigFile, sizeof (QEMU_FW_CFG_FILE));
-      return EFI_SUCCESS;
+  // Read the directory a few entries at a time, so each batch is a single DMA transfer
+  for (Idx = 0; Idx < FilesCount; Idx += BatchCount) {
+    BatchCount = MIN (FilesCount - Idx, FW_CFG_FILE_DIR_BATCH);
+    QemuFwCfgReadBytes (BatchCount * sizeof (QEMU_FW_CFG_FILE), FirmwareConfigFiles);
+
+    for (BatchIdx = 0; BatchIdx < BatchCount; BatchIdx++) {
+      FirmwareConfigFile = &FirmwareConfigFiles[BatchIdx];
+      if (AsciiStrCmp ((CHAR8 *)&(FirmwareConfigFile->Name), String) == 0) {
+        FirmwareConfigFile->Select = SwapBytes16 (FirmwareConfigFile->Select);
+        FirmwareConfigFile->Size   = SwapBytes32 (FirmwareConfigFile->Size);
+        CopyMem (FWConfigFile, FirmwareConfigFile, sizeof (QEMU_FW_CFG_FILE));
+        return EFI_SUCCESS;
+      }
     }
   }
 
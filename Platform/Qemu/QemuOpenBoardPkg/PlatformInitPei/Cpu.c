@@ -16,9 +16,109 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
 #include <Library/HobLib.h>
+#include <Library/PeiServicesLib.h>
+#include <Library/TimerLib.h>
+#include <Ppi/MpServices.h>
 
 /**
-  Probe Qemu FW CFG device for current CPU count and report to MpInitLib.
+  Does nothing, used to time how long the APs take to wake up.
+
+  @param[in] Buffer  Unused.
+ */
+STATIC
+VOID
+EFIAPI
+ApWakeupProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+}
+
+/**
+  Log the number of processors MpInitLib found, and how long it takes to wake
+  them all up.
+
+  @param[in] PeiServices       Indirect reference to the PEI Services Table.
+  @param[in] NotifyDescriptor  Address of the notification descriptor data structure.
+  @param[in] Ppi               Address of the MP Services PPI.
+
+  @return EFI_SUCCESS  Always.
+ */
+STATIC
+EFI_STATUS
+EFIAPI
+MpServicesNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  EFI_PEI_MP_SERVICES_PPI  *MpServices;
+  UINTN                    NumberOfProcessors;
+  UINTN                    NumberOfEnabledProcessors;
+  UINT64                   Start;
+  UINT64                   End;
+  EFI_STATUS               Status;
+
+  MpServices = Ppi;
+
+  Status = MpServices->GetNumberOfProcessors (
+                         (CONST EFI_PEI_SERVICES **)PeiServices,
+                         MpServices,
+                         &NumberOfProcessors,
+                         &NumberOfEnabledProcessors
+                         );
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "MpInitLib found %u processors (%u enabled), expected %u\n",
+    (UINT32)NumberOfProcessors,
+    (UINT32)NumberOfEnabledProcessors,
+    PcdGet32 (PcdCpuBootLogicalProcessorNumber)
+    ));
+
+  if (NumberOfEnabledProcessors < 2) {
+    return EFI_SUCCESS;
+  }
+
+  Start  = GetPerformanceCounter ();
+  Status = MpServices->StartupAllAPs (
+                         (CONST EFI_PEI_SERVICES **)PeiServices,
+                         MpServices,
+                         ApWakeupProcedure,
+                         FALSE,
+                         0,
+                         NULL
+                         );
+  End = GetPerformanceCounter ();
+
+  if (!EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_INFO,
+      "Woke up %u APs in %lu us\n",
+      (UINT32)(NumberOfEnabledProcessors - 1),
+      DivU64x32 (GetTimeInNanoSecond (End - Start), 1000)
+      ));
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC CONST EFI_PEI_NOTIFY_DESCRIPTOR  mMpServicesNotifyList = {
+  (EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST),
+  &gEfiPeiMpServicesPpiGuid,
+  MpServicesNotify
+};
+
+/**
+  Probe Qemu FW CFG device for current and possible CPU count and report to MpInitLib.
+
+  MpInitLib sizes its per-CPU data for PcdCpuMaxLogicalProcessorNumber, and
+  waits for exactly PcdCpuBootLogicalProcessorNumber CPUs to check in. It
+  switches to x2APIC mode on its own once it finds an APIC ID above 254.
 
   @return EFI_SUCCESS      Detection was successful.
   @retval EFI_UNSUPPORTED  QEMU FW CFG device is not present.
@@ -30,6 +130,7 @@ MaxCpuInit (
   )
 {
   UINT16      BootCpuCount;
+  UINT16      MaxCpuCount;
   EFI_STATUS  Status;
 
   Status = QemuFwCfgIsPresent ();
@@ -52,13 +153,29 @@ MaxCpuInit (
 
   QemuFwCfgReadBytes (sizeof (BootCpuCount), &BootCpuCount);
 
+  //
+  //  Possible CPUs, including the ones that can be hot-plugged later
+  //
+
+  Status = QemuFwCfgReadItem (QemuFwCfgItemMaximumCpuCount, sizeof (MaxCpuCount), &MaxCpuCount);
+
+  if (EFI_ERROR (Status) || (MaxCpuCount < BootCpuCount)) {
+    MaxCpuCount = BootCpuCount;
+  }
+
+  DEBUG ((DEBUG_INFO, "QEMU reports %u boot CPUs, %u possible CPUs\n", BootCpuCount, MaxCpuCount));
+
   //
   //  Report count to MpInitLib
   //
 
   PcdSet32S (PcdCpuBootLogicalProcessorNumber, BootCpuCount);
 
-  PcdSet32S (PcdCpuMaxLogicalProcessorNumber, 64);
+  PcdSet32S (PcdCpuMaxLogicalProcessorNumber, MaxCpuCount);
+
+  DEBUG_CODE_BEGIN ();
+  PeiServicesNotifyPpi (&mMpServicesNotifyList);
+  DEBUG_CODE_END ();
 
   return EFI_SUCCESS;
 }
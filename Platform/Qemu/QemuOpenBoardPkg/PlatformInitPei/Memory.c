@@ -13,47 +13,81 @@
 #include <IndustryStandard/E820.h>
 #include <Library/PcdLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/BaseLib.h>
+
+//
+// QEMU's E820 table usually has less than 10 entries
+//
+#define E820_MAX_ENTRIES  64
 
 /**
-  Return the memory size below 4GB.
+  Read the whole E820 table from QEMU FW CFG, in a single transfer.
 
-  @return Size of memory below 4GB, in bytes.
+  @param[out]     E820Table  Buffer for E820_MAX_ENTRIES entries.
+  @param[out]     Count      Number of entries read.
+
+  @retval EFI_SUCCESS     The table was read.
+  @retval EFI_NOT_FOUND   QEMU FW CFG device is not present.
+  @retval EFI_UNSUPPORTED etc/e820 file was not found.
 **/
-UINT32
-EFIAPI
-GetMemoryBelow4Gb (
-  VOID
+STATIC
+EFI_STATUS
+ReadE820Table (
+  OUT EFI_E820_ENTRY64  *E820Table,
+  OUT UINT32            *Count
   )
 {
-  EFI_E820_ENTRY64  E820Entry;
   QEMU_FW_CFG_FILE  FwCfgFile;
-  UINT32            Processed;
-  UINT64            Size;
   EFI_STATUS        Status;
 
   Status = QemuFwCfgIsPresent ();
   if (EFI_ERROR (Status)) {
-    return Status;
+    return EFI_NOT_FOUND;
   }
 
   Status = QemuFwCfgFindFile ("etc/e820", &FwCfgFile);
   if (EFI_ERROR (Status)) {
-    return Status;
+    return EFI_UNSUPPORTED;
+  }
+
+  *Count = FwCfgFile.Size / sizeof (EFI_E820_ENTRY64);
+  if (*Count > E820_MAX_ENTRIES) {
+    DEBUG ((DEBUG_ERROR, "etc/e820 has %u entries, only the first %u are used\n", *Count, E820_MAX_ENTRIES));
+    ASSERT (*Count <= E820_MAX_ENTRIES);
+    *Count = E820_MAX_ENTRIES;
   }
 
+  return QemuFwCfgReadItem (FwCfgFile.Select, *Count * sizeof (EFI_E820_ENTRY64), E820Table);
+}
+
+/**
+  Return the memory size below 4GB described by an E820 table.
+
+  @param[in]      E820Table  The E820 table.
+  @param[in]      Count      Number of entries in the table.
+
+  @return Size of memory below 4GB, in bytes.
+**/
+STATIC
+UINT32
+GetMemoryBelow4GbFromE820 (
+  IN CONST EFI_E820_ENTRY64  *E820Table,
+  IN UINT32                  Count
+  )
+{
+  UINT32  Processed;
+  UINT64  Size;
+
   Size = 0;
-  QemuFwCfgSelectItem (FwCfgFile.Select);
-  for (Processed = 0; Processed < FwCfgFile.Size / sizeof (EFI_E820_ENTRY); Processed++) {
-    QemuFwCfgReadBytes (sizeof (EFI_E820_ENTRY), &E820Entry);
-    if (E820Entry.Type != EfiAcpiAddressRangeMemory) {
+  for (Processed = 0; Processed < Count; Processed++) {
+    if (E820Table[Processed].Type != EfiAcpiAddressRangeMemory) {
       continue;
     }
 
-    if (E820Entry.BaseAddr + E820Entry.Length < SIZE_4GB) {
-      Size += E820Entry.Length;
+    if (E820Table[Processed].BaseAddr + E820Table[Processed].Length < SIZE_4GB) {
+      Size += E820Table[Processed].Length;
     } else {
-      ASSERT (Size == (UINT32)Size);
-      return (UINT32) Size;
+      break;
     }
   }
 
@@ -61,6 +95,29 @@ GetMemoryBelow4Gb (
   return (UINT32) Size;
 }
 
+/**
+  Return the memory size below 4GB.
+
+  @return Size of memory below 4GB, in bytes, or 0 if it could not be read.
+**/
+UINT32
+EFIAPI
+GetMemoryBelow4Gb (
+  VOID
+  )
+{
+  EFI_E820_ENTRY64  E820Table[E820_MAX_ENTRIES];
+  UINT32            Count;
+  EFI_STATUS        Status;
+
+  Status = ReadE820Table (E820Table, &Count);
+  if (EFI_ERROR (Status)) {
+    return 0;
+  }
+
+  return GetMemoryBelow4GbFromE820 (E820Table, Count);
+}
+
 /**
   Reserve an MMIO region.
 
@@ -106,36 +163,33 @@ InstallMemory (
 {
   EFI_STATUS                   Status;
   CONST EFI_PEI_SERVICES       **PeiServicesTable;
+  EFI_E820_ENTRY64             E820Table[E820_MAX_ENTRIES];
   EFI_E820_ENTRY64             E820Entry;
   EFI_E820_ENTRY64             LargestE820Entry;
-  QEMU_FW_CFG_FILE             FwCfgFile;
+  UINT32                       E820Count;
   UINT32                       Processed;
   BOOLEAN                      ValidMemory;
   EFI_RESOURCE_TYPE            ResourceType;
   EFI_RESOURCE_ATTRIBUTE_TYPE  ResourceAttributes;
   UINT32                       MemoryBelow4G;
+  UINT64                       MemoryAbove4G;
   UINT32                       RequiredBySmm;
 
-  Status = QemuFwCfgIsPresent ();
-  if (EFI_ERROR (Status)) {
+  Status = ReadE820Table (E820Table, &E820Count);
+  if (Status == EFI_NOT_FOUND) {
     DEBUG ((DEBUG_INFO, "QEMU fw_cfg device is not present\n"));
     return EFI_NOT_FOUND;
-  } else {
-    DEBUG ((DEBUG_INFO, "QEMU fw_cfg device is present\n"));
-  }
-
-  Status = QemuFwCfgFindFile ("etc/e820", &FwCfgFile);
-  if (EFI_ERROR (Status)) {
+  } else if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "etc/e820 was not found \n"));
     return EFI_UNSUPPORTED;
   }
 
-  MemoryBelow4G = GetMemoryBelow4Gb ();
+  MemoryBelow4G = GetMemoryBelow4GbFromE820 (E820Table, E820Count);
+  MemoryAbove4G = 0;
 
   LargestE820Entry.Length = 0;
-  QemuFwCfgSelectItem (FwCfgFile.Select);
-  for (Processed = 0; Processed < FwCfgFile.Size / sizeof (EFI_E820_ENTRY); Processed++) {
-    QemuFwCfgReadBytes (sizeof (EFI_E820_ENTRY), &E820Entry);
+  for (Processed = 0; Processed < E820Count; Processed++) {
+    CopyMem (&E820Entry, &E820Table[Processed], sizeof (EFI_E820_ENTRY64));
 
     ValidMemory        = E820Entry.Type == EfiAcpiAddressRangeMemory;
     ResourceType       = EFI_RESOURCE_MEMORY_RESERVED;
@@ -197,6 +251,10 @@ InstallMemory (
       // Note that we can only check if this is the largest entry after reserving everything we have to reserve
       //
 
+      if (E820Entry.BaseAddr >= SIZE_4GB) {
+        MemoryAbove4G += E820Entry.Length;
+      }
+
       if ((E820Entry.Length > LargestE820Entry.Length) && (E820Entry.BaseAddr + E820Entry.Length <= SIZE_4GB)) {
         CopyMem (&LargestE820Entry, &E820Entry, sizeof (EFI_E820_ENTRY64));
         DEBUG ((
@@ -224,6 +282,13 @@ InstallMemory (
       ));
   }
 
+  DEBUG ((
+    DEBUG_INFO,
+    "System memory: %u MiB below 4GB, %lu MiB above 4GB\n",
+    MemoryBelow4G / SIZE_1MB,
+    RShiftU64 (MemoryAbove4G, 20)
+    ));
+
   ASSERT (LargestE820Entry.Length != 0);
   DEBUG ((
     DEBUG_INFO,
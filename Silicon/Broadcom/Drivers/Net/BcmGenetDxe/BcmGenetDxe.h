@@ -114,6 +114,7 @@
 #define GENET_DMA_DESC_COUNT                    256
 #define GENET_DMA_DESC_SIZE                     12
 #define GENET_DMA_DEFAULT_QUEUE                 16
+#define GENET_RX_RECYCLE_BATCH                  16
 
 #define GENET_DMA_RING_SIZE                     0x40
 #define GENET_DMA_RINGS_SIZE                    (GENET_DMA_RING_SIZE * (GENET_DMA_DEFAULT_QUEUE + 1))
@@ -227,6 +228,7 @@ typedef struct {
   GENET_MAP_INFO                      RxBufferMap[GENET_DMA_DESC_COUNT];
   UINT16                              RxConsIndex;
   UINT16                              RxProdIndex;
+  UINT16                              RxUnrecycled;
 
   GENET_PHY_MODE                      PhyMode;
 
@@ -353,6 +355,13 @@ GenetDmaUnmapRxDescriptor (
   IN UINT8               DescIndex
   );
 
+VOID
+GenetDmaSyncRxDescriptor (
+  IN GENET_PRIVATE_DATA *Genet,
+  IN UINT8              DescIndex,
+  IN UINTN              FrameLength
+  );
+
 VOID
 GenetTxIntr (
   IN GENET_PRIVATE_DATA *Genet,
@@ -7,6 +7,7 @@
 **/
 
 #include <Uefi.h>
+#include <Library/CacheMaintenanceLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DmaLib.h>
 #include <Library/IoLib.h>
@@ -550,6 +551,7 @@ GenetDmaInitRings (
 
   Genet->RxConsIndex = 0;
   Genet->RxProdIndex = 0;
+  Genet->RxUnrecycled = 0;
 
   // Configure TX queue
   GenetMmioWrite (Genet, GENET_TX_SCB_BURST_SIZE, 0x08);
@@ -626,6 +628,9 @@ GenetDmaAlloc (
 /**
   Given an RX buffer descriptor index, program the IO address of the buffer into the hardware.
 
+  The buffer stays mapped until GenetDmaUnmapRxDescriptor, across every frame received into
+  it, so the receive path only needs GenetDmaSyncRxDescriptor.
+
   @param  Genet[in]      Pointer to GENET_PRIVATE_DATA.
   @param  DescIndex[in]  Index of RX buffer descriptor.
 
@@ -657,6 +662,14 @@ GenetDmaMapRxDescriptor (
     return Status;
   }
 
+  //
+  // GenetDmaSyncRxDescriptor operates on the buffer itself, so DmaMap must not
+  // have handed us a bounce buffer. GenetDmaAlloc allocated the buffers below
+  // the DMA limit, and GENET_MAX_PACKET_SIZE is a multiple of the cache line size.
+  //
+  ASSERT (Genet->RxBufferMap[DescIndex].PhysAddress ==
+          (UINTN)GENET_RX_BUFFER (Genet, DescIndex) + FixedPcdGet64 (PcdDmaDeviceOffset));
+
   GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_LO (DescIndex),
     Genet->RxBufferMap[DescIndex].PhysAddress & 0xFFFFFFFF);
   GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_HI (DescIndex),
@@ -685,6 +698,32 @@ GenetDmaUnmapRxDescriptor (
   }
 }
 
+/**
+  Make a frame received into an RX buffer visible to the CPU.
+
+  Any cache lines covering the buffer, including ones speculatively loaded while the
+  hardware owned it, are discarded, but only over the received length.
+
+  @param  Genet[in]        Pointer to GENET_PRIVATE_DATA.
+  @param  DescIndex[in]    Index of RX buffer descriptor.
+  @param  FrameLength[in]  Number of bytes the hardware wrote to the buffer.
+
+**/
+VOID
+GenetDmaSyncRxDescriptor (
+  IN GENET_PRIVATE_DATA * Genet,
+  IN UINT8                DescIndex,
+  IN UINTN                FrameLength
+  )
+{
+  ASSERT (Genet->RxBufferMap[DescIndex].Mapping != NULL);
+  ASSERT (FrameLength <= GENET_MAX_PACKET_SIZE);
+
+  if (FrameLength > 0) {
+    InvalidateDataCacheRange (GENET_RX_BUFFER (Genet, DescIndex), FrameLength);
+  }
+}
+
 /**
   Free DMA buffers for RX, undoing GenetDmaAlloc.
 
@@ -773,16 +812,17 @@ GenetRxPending (
   IN  GENET_PRIVATE_DATA *Genet
   )
 {
-  UINT32 ProdIndex;
+  DEBUG_CODE_BEGIN ();
   UINT32 ConsIndex;
 
   ConsIndex = GenetMmioRead (Genet,
                 GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE)) & 0xFFFF;
-  ASSERT (ConsIndex == Genet->RxConsIndex);
+  ASSERT (ConsIndex == ((Genet->RxConsIndex - Genet->RxUnrecycled) & 0xFFFF));
+  DEBUG_CODE_END ();
 
-  ProdIndex = GenetMmioRead (Genet,
-                GENET_RX_DMA_PROD_INDEX (GENET_DMA_DEFAULT_QUEUE)) & 0xFFFF;
-  return (ProdIndex - Genet->RxConsIndex) & 0xFFFF;
+  Genet->RxProdIndex = GenetMmioRead (Genet,
+                         GENET_RX_DMA_PROD_INDEX (GENET_DMA_DEFAULT_QUEUE)) & 0xFFFF;
+  return (Genet->RxProdIndex - Genet->RxConsIndex) & 0xFFFF;
 }
 
 UINT32
@@ -798,14 +838,30 @@ GenetTxPending (
   return (ConsIndex - Genet->TxConsIndex) & 0xFFFF;
 }
 
+/**
+  Consume the RX buffer returned by GenetRxIntr, handing it back to the hardware.
+
+  Buffers are returned with a single consumer index write, once GENET_RX_RECYCLE_BATCH
+  of them have been consumed or once every frame seen by the last GenetRxPending has
+  been, so that an idle ring never holds on to any buffers.
+
+  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
+
+**/
 VOID
 GenetRxComplete (
   IN GENET_PRIVATE_DATA *Genet
   )
 {
   Genet->RxConsIndex = (Genet->RxConsIndex + 1) & 0xFFFF;
-  GenetMmioWrite (Genet, GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE),
-                  Genet->RxConsIndex);
+  Genet->RxUnrecycled++;
+
+  if ((Genet->RxUnrecycled >= GENET_RX_RECYCLE_BATCH) ||
+      (Genet->RxConsIndex == Genet->RxProdIndex)) {
+    GenetMmioWrite (Genet, GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE),
+                    Genet->RxConsIndex);
+    Genet->RxUnrecycled = 0;
+  }
 }
 
 /**
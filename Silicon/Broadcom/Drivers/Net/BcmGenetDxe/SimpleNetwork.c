@@ -757,9 +757,8 @@ GenetSimpleNetworkReceive (
     return Status;
   }
 
-  ASSERT (Genet->RxBufferMap[DescIndex].Mapping != NULL);
-
-  GenetDmaUnmapRxDescriptor (Genet, DescIndex);
+  FrameLength = MIN (FrameLength, GENET_MAX_PACKET_SIZE);
+  GenetDmaSyncRxDescriptor (Genet, DescIndex, FrameLength);
 
   Frame = GENET_RX_BUFFER (Genet, DescIndex);
 
@@ -772,8 +771,13 @@ GenetSimpleNetworkReceive (
       DEBUG ((DEBUG_ERROR,
         "%a: Buffer size (0x%X) is too small for frame (0x%X)\n",
         __FUNCTION__, *BufferSize, FrameLength));
-      Status = EFI_BUFFER_TOO_SMALL;
-      goto out;
+      //
+      // Leave the frame on the ring, so that the caller can retry with
+      // a buffer of the size it needs.
+      //
+      *BufferSize = FrameLength;
+      EfiReleaseLock (&Genet->Lock);
+      return EFI_BUFFER_TOO_SMALL;
     }
 
     if (DestAddr != NULL) {
@@ -799,12 +803,6 @@ GenetSimpleNetworkReceive (
     Status = EFI_NOT_READY;
   }
 
-out:
-  Status = GenetDmaMapRxDescriptor (Genet, DescIndex);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Failed to remap RX descriptor!\n", __FUNCTION__));
-  }
-
   GenetRxComplete (Genet);
 
   EfiReleaseLock (&Genet->Lock);
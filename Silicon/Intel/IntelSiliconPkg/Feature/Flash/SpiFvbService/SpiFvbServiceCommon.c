@@ -16,6 +16,16 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 FVB_GLOBAL   mFvbModuleGlobal;
 
+//
+// Flash access counters, reported through the gSpiFvbStatisticsGuid MMI
+//
+SPI_FVB_STATISTICS  mFvbStatistics;
+
+//
+// Adjacent writes waiting to be issued to flash when PcdSpiFvbWriteCoalescing is TRUE
+//
+FVB_WRITE_JOURNAL   mFvbWriteJournal;
+
 //
 // This platform driver knows there are multiple FVs on FD.
 // Now we only provide FVs on Variable region and MicorCode region for performance issue.
@@ -235,6 +245,14 @@ FvbReadBlock (
     return EFI_ACCESS_DENIED;
   }
 
+  //
+  // Make sure the read returns the data of any pending write
+  //
+  Status = FvbFlushWriteJournal ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   if (BlockOffset > LbaLength) {
    return EFI_INVALID_PARAMETER;
   }
@@ -258,6 +276,146 @@ FvbReadBlock (
   }
 }
 
+/**
+  Writes a buffer to flash, then locks the flash and invalidates the written
+  range from the cache.
+
+  @param[in]      Address           The starting physical address of the write
+  @param[in,out]  NumBytes          On input, the number of bytes to write. On output,
+                                    the number of bytes actually written
+  @param[in]      Buffer            The source data buffer of the write
+
+  @retval         EFI_SUCCESS       The data was written successfully
+  @retval         Others            The flash could not be written or locked
+
+**/
+STATIC
+EFI_STATUS
+FvbFlashWrite (
+  IN     UINTN                            Address,
+  IN OUT UINT32                           *NumBytes,
+  IN     UINT8                            *Buffer
+  )
+{
+  EFI_STATUS                              Status;
+
+  mFvbStatistics.FlashWriteCommands++;
+  Status = SpiFlashWrite (Address, NumBytes, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mFvbStatistics.FlashLocks++;
+  Status = SpiFlashLock ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  WriteBackInvalidateDataCacheRange ((VOID *) Address, *NumBytes);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Issues the writes held in the write journal to flash.
+
+  @retval     EFI_SUCCESS           The journal was empty or was written successfully
+  @retval     EFI_DEVICE_ERROR      The block device is not functioning correctly and
+                                    the pending writes could not be written
+
+**/
+EFI_STATUS
+FvbFlushWriteJournal (
+  VOID
+  )
+{
+  EFI_STATUS                              Status;
+  UINT32                                  PendingLength;
+  UINT32                                  Length;
+
+  if (mFvbWriteJournal.Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The journal is dropped even on failure. The caller that wrote the data has
+  // already been told it succeeded, so the error goes to the current caller.
+  //
+  PendingLength           = mFvbWriteJournal.Length;
+  Length                  = PendingLength;
+  mFvbWriteJournal.Length = 0;
+
+  Status = FvbFlashWrite (mFvbWriteJournal.Address, &Length, mFvbWriteJournal.Data);
+  if (EFI_ERROR (Status) || (Length != PendingLength)) {
+    DEBUG ((DEBUG_ERROR, "FvbFlushWriteJournal: Failed to write 0x%x bytes at 0x%lx - %r\n", PendingLength, (UINT64) mFvbWriteJournal.Address, Status));
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Writes a buffer to flash through the write journal.
+
+  A write that directly follows the pending data, and still fits in a burst of
+  PcdSpiFvbWriteBurstSize bytes, is appended to the journal. Anything else
+  flushes the journal first. The variable and FTW stores commit a record by
+  writing its one byte state field after the record data, so a one byte write
+  flushes the journal before returning. This keeps the on-flash ordering of
+  data and state, and a store never reports a record committed unless it is
+  on flash.
+
+  @param[in]      Address           The starting physical address of the write
+  @param[in,out]  NumBytes          On input, the number of bytes to write. On output,
+                                    the number of bytes actually written or journaled
+  @param[in]      Buffer            The source data buffer of the write
+
+  @retval         EFI_SUCCESS       The data was written or journaled successfully
+  @retval         Others            The flash could not be written
+
+**/
+STATIC
+EFI_STATUS
+FvbJournalWrite (
+  IN     UINTN                            Address,
+  IN OUT UINT32                           *NumBytes,
+  IN     UINT8                            *Buffer
+  )
+{
+  EFI_STATUS                              Status;
+  UINT32                                  BurstSize;
+
+  BurstSize = MIN (FixedPcdGet32 (PcdSpiFvbWriteBurstSize), FVB_WRITE_JOURNAL_SIZE_MAX);
+
+  if ((mFvbWriteJournal.Length != 0) &&
+      ((Address != mFvbWriteJournal.Address + mFvbWriteJournal.Length) ||
+       (*NumBytes > BurstSize - mFvbWriteJournal.Length))) {
+    Status = FvbFlushWriteJournal ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (*NumBytes >= BurstSize) {
+    return FvbFlashWrite (Address, NumBytes, Buffer);
+  }
+
+  if (mFvbWriteJournal.Length == 0) {
+    mFvbWriteJournal.Address = Address;
+  } else {
+    mFvbStatistics.CoalescedWrites++;
+  }
+
+  CopyMem (&mFvbWriteJournal.Data[mFvbWriteJournal.Length], Buffer, *NumBytes);
+  mFvbWriteJournal.Length += *NumBytes;
+
+  if ((*NumBytes == sizeof (UINT8)) || (mFvbWriteJournal.Length == BurstSize)) {
+    return FvbFlushWriteJournal ();
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Writes specified number of bytes from the input buffer to the block.
 
@@ -331,18 +489,18 @@ FvbWriteBlock (
     BadBufferSize = TRUE;
   }
 
-  Status = SpiFlashWrite (LbaAddress + BlockOffset, (UINT32 *)NumBytes, Buffer);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
+  mFvbStatistics.WriteRequests++;
+  mFvbStatistics.BytesWritten += *NumBytes;
 
-  Status = SpiFlashLock ();
+  if (FeaturePcdGet (PcdSpiFvbWriteCoalescing)) {
+    Status = FvbJournalWrite (LbaAddress + BlockOffset, (UINT32 *)NumBytes, Buffer);
+  } else {
+    Status = FvbFlashWrite (LbaAddress + BlockOffset, (UINT32 *)NumBytes, Buffer);
+  }
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  WriteBackInvalidateDataCacheRange ((VOID *) (LbaAddress + BlockOffset), *NumBytes);
-
   if (!EFI_ERROR (Status) && BadBufferSize) {
     return EFI_BAD_BUFFER_SIZE;
   } else {
@@ -395,11 +553,21 @@ FvbEraseBlock (
     return Status;
   }
 
+  //
+  // Pending writes were issued before the erase, so they must reach flash first
+  //
+  Status = FvbFlushWriteJournal ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mFvbStatistics.BlockErases++;
   Status = SpiFlashBlockErase (LbaAddress, &LbaLength);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  mFvbStatistics.FlashLocks++;
   Status = SpiFlashLock ();
   if (EFI_ERROR (Status)) {
     return Status;
@@ -438,6 +606,7 @@ FvbSetVolumeAttributes (
   EFI_FVB_ATTRIBUTES_2                      UnchangedAttributes;
   UINT32                                    Capabilities;
   UINT32                                    OldStatus, NewStatus;
+  EFI_STATUS                                Status;
 
   AttribPtr     = (EFI_FVB_ATTRIBUTES_2 *) &(FvbInstance->FvHeader.Attributes);
   OldAttributes = *AttribPtr;
@@ -518,6 +687,15 @@ FvbSetVolumeAttributes (
     }
   }
 
+  //
+  // Pending writes were accepted under the old attributes, so they must reach
+  // flash before the volume is write disabled or locked
+  //
+  Status = FvbFlushWriteJournal ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   *AttribPtr  = (*AttribPtr) & (0xFFFFFFFF & (~EFI_FVB2_STATUS));
   *AttribPtr  = (*AttribPtr) | NewStatus;
   *Attributes = *AttribPtr;
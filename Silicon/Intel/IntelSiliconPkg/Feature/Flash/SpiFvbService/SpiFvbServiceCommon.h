@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/EventGroup.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/SystemNvDataGuid.h>
+#include <Guid/SpiFvbStatistics.h>
 #include <Pi/PiFirmwareVolume.h>
 #include <Protocol/DevicePath.h>
 #include <Protocol/FirmwareVolumeBlock.h>
@@ -80,6 +81,21 @@ typedef struct {
   UINT32              FvSize;
 } FV_INFO;
 
+//
+// Largest supported PcdSpiFvbWriteBurstSize.
+//
+#define FVB_WRITE_JOURNAL_SIZE_MAX    SIZE_4KB
+
+//
+// Writes waiting to be issued to flash as a single burst. Data holds Length
+// bytes that belong at flash address Address.
+//
+typedef struct {
+  UINTN               Address;
+  UINT32              Length;
+  UINT8               Data[FVB_WRITE_JOURNAL_SIZE_MAX];
+} FVB_WRITE_JOURNAL;
+
 //
 // Protocol APIs
 //
@@ -140,6 +156,19 @@ FvbProtocolEraseBlocks (
   ...
   );
 
+/**
+  Issues the writes held in the write journal to flash.
+
+  @retval     EFI_SUCCESS           The journal was empty or was written successfully
+  @retval     EFI_DEVICE_ERROR      The block device is not functioning correctly and
+                                    the pending writes could not be written
+
+**/
+EFI_STATUS
+FvbFlushWriteJournal (
+  VOID
+  );
+
 BOOLEAN
 IsFvHeaderValid (
   IN       EFI_PHYSICAL_ADDRESS          FvBase,
@@ -170,5 +199,6 @@ extern FV_MEMMAP_DEVICE_PATH              mFvMemmapDevicePathTemplate;
 extern FV_PIWG_DEVICE_PATH                mFvPIWGDevicePathTemplate;
 extern EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL mFvbProtocolTemplate;
 extern FV_INFO                            mPlatformFvBaseAddress[];
+extern SPI_FVB_STATISTICS                 mFvbStatistics;
 
 #endif
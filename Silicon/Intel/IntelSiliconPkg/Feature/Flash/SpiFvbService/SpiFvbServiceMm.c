@@ -9,6 +9,7 @@
 **/
 
 #include "SpiFvbServiceCommon.h"
+#include "SpiFvbServiceMm.h"
 #include <Library/MmServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Protocol/SmmFirmwareVolumeBlock.h>
@@ -94,6 +95,51 @@ InstallFvbProtocol (
   ASSERT_EFI_ERROR (Status);
 }
 
+/**
+  MMI handler that returns the flash access counters of this driver.
+
+  The communicate buffer must hold exactly one SPI_FVB_STATISTICS structure,
+  which is overwritten with the current counters.
+
+  @param[in]     DispatchHandle  The unique handle assigned to this handler by MmiHandlerRegister().
+  @param[in]     Context         Points to an optional handler context which was specified when the
+                                 handler was registered.
+  @param[in,out] CommBuffer      A pointer to a collection of data in memory that will
+                                 be conveyed from a non-MM environment into an MM environment.
+  @param[in,out] CommBufferSize  The size of the CommBuffer.
+
+  @retval EFI_SUCCESS            The interrupt was handled and quiesced. No other handlers
+                                 should still be called.
+
+**/
+EFI_STATUS
+EFIAPI
+SpiFvbStatisticsHandler (
+  IN     EFI_HANDLE                   DispatchHandle,
+  IN     CONST VOID                   *Context         OPTIONAL,
+  IN OUT VOID                         *CommBuffer      OPTIONAL,
+  IN OUT UINTN                        *CommBufferSize  OPTIONAL
+  )
+{
+  if ((CommBuffer == NULL) || (CommBufferSize == NULL)) {
+    return EFI_SUCCESS;
+  }
+
+  if (*CommBufferSize != sizeof (SPI_FVB_STATISTICS)) {
+    DEBUG ((DEBUG_ERROR, "SpiFvbStatisticsHandler: MM communication buffer size invalid!\n"));
+    return EFI_SUCCESS;
+  }
+
+  if (!SpiFvbIsBufferOutsideMmValid ((UINTN) CommBuffer, *CommBufferSize)) {
+    DEBUG ((DEBUG_ERROR, "SpiFvbStatisticsHandler: MM communication buffer in MMRAM or overflow!\n"));
+    return EFI_SUCCESS;
+  }
+
+  CopyMem (CommBuffer, &mFvbStatistics, sizeof (SPI_FVB_STATISTICS));
+
+  return EFI_SUCCESS;
+}
+
 /**
   The function does the necessary initialization work for
   Firmware Volume Block Driver.
@@ -120,6 +166,7 @@ FvbInitialize (
   VARIABLE_STORE_HEADER                 *VariableStoreHeader;
   UINT8                                 VariableStoreType;
   UINT8                                 *NvStoreBuffer;
+  EFI_HANDLE                            DispatchHandle;
 
   Status = GetVariableFlashNvStorageInfo (&BaseAddress, &NvStorageFvSize);
   if (EFI_ERROR (Status)) {
@@ -363,4 +410,8 @@ FvbInitialize (
 
     }
   }
+
+  DispatchHandle = NULL;
+  Status = gMmst->MmiHandlerRegister (SpiFvbStatisticsHandler, &gSpiFvbStatisticsGuid, &DispatchHandle);
+  ASSERT_EFI_ERROR (Status);
 }
@@ -9,6 +9,7 @@
 
 #include "SpiFvbServiceCommon.h"
 #include "SpiFvbServiceMm.h"
+#include <Library/StandaloneMmMemLib.h>
 
 /**
   The driver Standalone MM entry point.
@@ -30,3 +31,24 @@ SpiFvbStandaloneMmInitialize (
 
   return EFI_SUCCESS;
 }
+
+/**
+  This function checks if the buffer is valid per processor architecture and
+  does not overlap with MMRAM.
+
+  @param[in] Buffer       The buffer start address to be checked.
+  @param[in] Length       The buffer length to be checked.
+
+  @retval TRUE  This buffer is valid per processor architecture and does not
+                overlap with MMRAM.
+  @retval FALSE This buffer is not valid per processor architecture or overlaps
+                with MMRAM.
+**/
+BOOLEAN
+SpiFvbIsBufferOutsideMmValid (
+  IN EFI_PHYSICAL_ADDRESS  Buffer,
+  IN UINT64                Length
+  )
+{
+  return MmIsBufferOutsideMmValid (Buffer, Length);
+}
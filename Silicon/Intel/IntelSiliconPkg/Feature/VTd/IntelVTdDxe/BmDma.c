@@ -21,20 +21,202 @@ typedef struct {
 } MAP_HANDLE_INFO;
 #define MAP_HANDLE_INFO_FROM_LINK(a) CR (a, MAP_HANDLE_INFO, Link, MAP_HANDLE_INFO_SIGNATURE)
 
+//
+// A bounce buffer from the pre-allocated pool.
+//
+typedef struct {
+  LIST_ENTRY                                Link;
+  EFI_PHYSICAL_ADDRESS                      Address;
+  UINTN                                     ClassIndex;
+} BOUNCE_BUFFER;
+#define BOUNCE_BUFFER_FROM_LINK(a) BASE_CR (a, BOUNCE_BUFFER, Link)
+
+typedef struct {
+  UINTN                                     NumberOfPages;
+  UINTN                                     NumberOfBuffers;
+  LIST_ENTRY                                FreeList;
+} BOUNCE_BUFFER_CLASS;
+
+//
+// Size classes of the bounce buffer pool. Map() requests that do not fit in
+// a free buffer of the pool get their bounce buffer from AllocatePages().
+//
+BOUNCE_BUFFER_CLASS               mBounceBufferClass[] = {
+  { 1,  16 },
+  { 2,  8  },
+  { 4,  8  },
+  { 8,  4  },
+  { 16, 4  },
+};
+
 #define MAP_INFO_SIGNATURE  SIGNATURE_32 ('D', 'M', 'A', 'P')
 typedef struct {
   UINT32                                    Signature;
   LIST_ENTRY                                Link;
+  LIST_ENTRY                                DeviceAddressLink;
   EDKII_IOMMU_OPERATION                     Operation;
   UINTN                                     NumberOfBytes;
   UINTN                                     NumberOfPages;
   EFI_PHYSICAL_ADDRESS                      HostAddress;
   EFI_PHYSICAL_ADDRESS                      DeviceAddress;
+  BOUNCE_BUFFER                             *BounceBuffer;
   LIST_ENTRY                                HandleList;
 } MAP_INFO;
 #define MAP_INFO_FROM_LINK(a) CR (a, MAP_INFO, Link, MAP_INFO_SIGNATURE)
+#define MAP_INFO_FROM_DEVICE_ADDRESS_LINK(a) CR (a, MAP_INFO, DeviceAddressLink, MAP_INFO_SIGNATURE)
+
+//
+// The live mappings are hashed by Mapping (the MAP_INFO pointer), for Unmap(),
+// and by DeviceAddress, for SetAttribute().
+//
+#define MAP_INFO_HASH_SIZE                 64
+#define MAP_INFO_HASH(Value, Shift)        ((UINTN)RShiftU64 ((UINT64)(Value), Shift) & (MAP_INFO_HASH_SIZE - 1))
+#define MAP_INFO_HASH_MAPPING(Mapping)     MAP_INFO_HASH ((UINTN)(Mapping), 4)
+#define MAP_INFO_HASH_DEVICE_ADDRESS(Addr) MAP_INFO_HASH ((Addr), EFI_PAGE_SHIFT)
+
+LIST_ENTRY                        mMapsByMapping[MAP_INFO_HASH_SIZE];
+LIST_ENTRY                        mMapsByDeviceAddress[MAP_INFO_HASH_SIZE];
+
+/**
+  Initialize the mapping hash tables and pre-allocate the bounce buffer pool.
+**/
+VOID
+InitializeBmDma (
+  VOID
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     Index;
+  UINTN                     ClassIndex;
+  UINTN                     TotalPages;
+  UINTN                     TotalBuffers;
+  EFI_PHYSICAL_ADDRESS      PoolAddress;
+  BOUNCE_BUFFER             *BounceBuffer;
+
+  for (Index = 0; Index < MAP_INFO_HASH_SIZE; Index++) {
+    InitializeListHead (&mMapsByMapping[Index]);
+    InitializeListHead (&mMapsByDeviceAddress[Index]);
+  }
+
+  TotalPages = 0;
+  TotalBuffers = 0;
+  for (ClassIndex = 0; ClassIndex < ARRAY_SIZE (mBounceBufferClass); ClassIndex++) {
+    InitializeListHead (&mBounceBufferClass[ClassIndex].FreeList);
+    TotalPages += mBounceBufferClass[ClassIndex].NumberOfPages * mBounceBufferClass[ClassIndex].NumberOfBuffers;
+    TotalBuffers += mBounceBufferClass[ClassIndex].NumberOfBuffers;
+  }
+
+  //
+  // The pool must be usable by devices that cannot do DMA above 4GB.
+  //
+  PoolAddress = MIN (DMA_MEMORY_TOP, SIZE_4GB - 1);
+  Status = gBS->AllocatePages (
+                  AllocateMaxAddress,
+                  EfiBootServicesData,
+                  TotalPages,
+                  &PoolAddress
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "InitializeBmDma: No bounce buffer pool - %r\n", Status));
+    return ;
+  }
+
+  BounceBuffer = AllocatePool (TotalBuffers * sizeof (BOUNCE_BUFFER));
+  if (BounceBuffer == NULL) {
+    DEBUG ((DEBUG_WARN, "InitializeBmDma: No bounce buffer pool - %r\n", EFI_OUT_OF_RESOURCES));
+    gBS->FreePages (PoolAddress, TotalPages);
+    return ;
+  }
+
+  for (ClassIndex = 0; ClassIndex < ARRAY_SIZE (mBounceBufferClass); ClassIndex++) {
+    for (Index = 0; Index < mBounceBufferClass[ClassIndex].NumberOfBuffers; Index++) {
+      BounceBuffer->Address    = PoolAddress;
+      BounceBuffer->ClassIndex = ClassIndex;
+      InsertTailList (&mBounceBufferClass[ClassIndex].FreeList, &BounceBuffer->Link);
+      PoolAddress += EFI_PAGES_TO_SIZE (mBounceBufferClass[ClassIndex].NumberOfPages);
+      BounceBuffer++;
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "InitializeBmDma: Bounce buffer pool - %d buffers, %d pages\n", TotalBuffers, TotalPages));
+}
+
+/**
+  Get a free bounce buffer from the pool.
+
+  The caller must be at VTD_TPL_LEVEL.
+
+  @param[in]  NumberOfPages     The number of pages of the bounce buffer.
+
+  @return The bounce buffer, or NULL if there is no free buffer large enough.
+**/
+BOUNCE_BUFFER *
+AllocateBounceBuffer (
+  IN UINTN  NumberOfPages
+  )
+{
+  UINTN          ClassIndex;
+  LIST_ENTRY     *Link;
+
+  //
+  // Use the smallest class that fits, or a larger one if it has run out of buffers.
+  //
+  for (ClassIndex = 0; ClassIndex < ARRAY_SIZE (mBounceBufferClass); ClassIndex++) {
+    if ((mBounceBufferClass[ClassIndex].NumberOfPages >= NumberOfPages) &&
+        !IsListEmpty (&mBounceBufferClass[ClassIndex].FreeList)) {
+      Link = GetFirstNode (&mBounceBufferClass[ClassIndex].FreeList);
+      RemoveEntryList (Link);
+      return BOUNCE_BUFFER_FROM_LINK (Link);
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Return a bounce buffer to the pool.
+
+  The caller must be at VTD_TPL_LEVEL.
+
+  @param[in]  BounceBuffer      The bounce buffer.
+**/
+VOID
+FreeBounceBuffer (
+  IN BOUNCE_BUFFER  *BounceBuffer
+  )
+{
+  InsertHeadList (&mBounceBufferClass[BounceBuffer->ClassIndex].FreeList, &BounceBuffer->Link);
+}
+
+/**
+  Find the MAP_INFO of a Mapping returned by Map().
 
-LIST_ENTRY                        gMaps = INITIALIZE_LIST_HEAD_VARIABLE(gMaps);
+  The caller must be at VTD_TPL_LEVEL.
+
+  @param[in]  Mapping           The mapping.
+
+  @return The MAP_INFO, or NULL if Mapping was not returned by Map().
+**/
+MAP_INFO *
+FindMapInfo (
+  IN VOID  *Mapping
+  )
+{
+  LIST_ENTRY               *Bucket;
+  LIST_ENTRY               *Link;
+
+  Bucket = &mMapsByMapping[MAP_INFO_HASH_MAPPING (Mapping)];
+  for (Link = GetFirstNode (Bucket)
+       ; !IsNull (Bucket, Link)
+       ; Link = GetNextNode (Bucket, Link)
+       ) {
+    if (MAP_INFO_FROM_LINK (Link) == Mapping) {
+      return MAP_INFO_FROM_LINK (Link);
+    }
+  }
+
+  return NULL;
+}
 
 /**
   This function fills DeviceHandle/IoMmuAccess to the MAP_HANDLE_INFO,
@@ -56,6 +238,7 @@ SyncDeviceHandleToMapInfo (
 {
   MAP_INFO                 *MapInfo;
   MAP_HANDLE_INFO          *MapHandleInfo;
+  LIST_ENTRY               *Bucket;
   LIST_ENTRY               *Link;
   EFI_TPL                  OriginalTpl;
 
@@ -64,11 +247,12 @@ SyncDeviceHandleToMapInfo (
   //
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
   MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
+  Bucket = &mMapsByDeviceAddress[MAP_INFO_HASH_DEVICE_ADDRESS (DeviceAddress)];
+  for (Link = GetFirstNode (Bucket)
+       ; !IsNull (Bucket, Link)
+       ; Link = GetNextNode (Bucket, Link)
        ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
+    MapInfo = MAP_INFO_FROM_DEVICE_ADDRESS_LINK (Link);
     if (MapInfo->DeviceAddress == DeviceAddress) {
       break;
     }
@@ -243,23 +427,35 @@ IoMmuMap (
   MapInfo->NumberOfPages     = EFI_SIZE_TO_PAGES (MapInfo->NumberOfBytes);
   MapInfo->HostAddress       = PhysicalAddress;
   MapInfo->DeviceAddress     = DmaMemoryTop;
+  MapInfo->BounceBuffer      = NULL;
   InitializeListHead(&MapInfo->HandleList);
 
   //
   // Allocate a buffer below 4GB to map the transfer to.
   //
   if (NeedRemap) {
-    Status = gBS->AllocatePages (
-                    AllocateMaxAddress,
-                    EfiBootServicesData,
-                    MapInfo->NumberOfPages,
-                    &MapInfo->DeviceAddress
-                    );
-    if (EFI_ERROR (Status)) {
-      FreePool (MapInfo);
-      *NumberOfBytes = 0;
-      DEBUG ((DEBUG_ERROR, "IoMmuMap: %r\n", Status));
-      return Status;
+    //
+    // The pool is below both DMA_MEMORY_TOP and 4GB, so it suits every operation.
+    //
+    OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+    MapInfo->BounceBuffer = AllocateBounceBuffer (MapInfo->NumberOfPages);
+    gBS->RestoreTPL (OriginalTpl);
+
+    if (MapInfo->BounceBuffer != NULL) {
+      MapInfo->DeviceAddress = MapInfo->BounceBuffer->Address;
+    } else {
+      Status = gBS->AllocatePages (
+                      AllocateMaxAddress,
+                      EfiBootServicesData,
+                      MapInfo->NumberOfPages,
+                      &MapInfo->DeviceAddress
+                      );
+      if (EFI_ERROR (Status)) {
+        FreePool (MapInfo);
+        *NumberOfBytes = 0;
+        DEBUG ((DEBUG_ERROR, "IoMmuMap: %r\n", Status));
+        return Status;
+      }
     }
 
     //
@@ -280,7 +476,8 @@ IoMmuMap (
   }
 
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
-  InsertTailList (&gMaps, &MapInfo->Link);
+  InsertTailList (&mMapsByMapping[MAP_INFO_HASH_MAPPING (MapInfo)], &MapInfo->Link);
+  InsertTailList (&mMapsByDeviceAddress[MAP_INFO_HASH_DEVICE_ADDRESS (MapInfo->DeviceAddress)], &MapInfo->DeviceAddressLink);
   gBS->RestoreTPL (OriginalTpl);
 
   //
@@ -316,7 +513,6 @@ IoMmuUnmap (
 {
   MAP_INFO                 *MapInfo;
   MAP_HANDLE_INFO          *MapHandleInfo;
-  LIST_ENTRY               *Link;
   EFI_TPL                  OriginalTpl;
 
   DEBUG ((DEBUG_VERBOSE, "IoMmuUnmap: 0x%08x\n", Mapping));
@@ -327,25 +523,17 @@ IoMmuUnmap (
   }
 
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
-  MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
-       ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
-    if (MapInfo == Mapping) {
-      break;
-    }
-  }
+  MapInfo = FindMapInfo (Mapping);
   //
   // Mapping is not a valid value returned by Map()
   //
-  if (MapInfo != Mapping) {
+  if (MapInfo == NULL) {
     gBS->RestoreTPL (OriginalTpl);
     DEBUG ((DEBUG_ERROR, "IoMmuUnmap: %r\n", EFI_INVALID_PARAMETER));
     return EFI_INVALID_PARAMETER;
   }
   RemoveEntryList (&MapInfo->Link);
+  RemoveEntryList (&MapInfo->DeviceAddressLink);
   gBS->RestoreTPL (OriginalTpl);
 
   //
@@ -375,7 +563,13 @@ IoMmuUnmap (
     //
     // Free the mapped buffer and the MAP_INFO structure.
     //
-    gBS->FreePages (MapInfo->DeviceAddress, MapInfo->NumberOfPages);
+    if (MapInfo->BounceBuffer != NULL) {
+      OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+      FreeBounceBuffer (MapInfo->BounceBuffer);
+      gBS->RestoreTPL (OriginalTpl);
+    } else {
+      gBS->FreePages (MapInfo->DeviceAddress, MapInfo->NumberOfPages);
+    }
   }
 
   FreePool (Mapping);
@@ -508,26 +702,19 @@ GetDeviceInfoFromMapping (
   )
 {
   MAP_INFO                 *MapInfo;
-  LIST_ENTRY               *Link;
+  EFI_TPL                  OriginalTpl;
 
   if (Mapping == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
-       ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
-    if (MapInfo == Mapping) {
-      break;
-    }
-  }
+  OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+  MapInfo = FindMapInfo (Mapping);
+  gBS->RestoreTPL (OriginalTpl);
   //
   // Mapping is not a valid value returned by Map()
   //
-  if (MapInfo != Mapping) {
+  if (MapInfo == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
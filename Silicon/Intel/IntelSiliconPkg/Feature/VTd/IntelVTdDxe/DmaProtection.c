@@ -594,6 +594,8 @@ OnExitBootServices (
 
   DEBUG ((DEBUG_INFO, "Invalidate all\n"));
   for (VtdIndex = 0; VtdIndex < mVtdUnitNumber; VtdIndex++) {
+    DumpVtdInvalidationStatistics (VtdIndex);
+
     FlushWriteBuffer (VtdIndex);
 
     InvalidateContextCache (VtdIndex);
@@ -53,6 +53,27 @@
 #define VTD_QUEUED_INVALIDATION_DESCRIPTOR_WIDTH 1
 #define VTD_INVALIDATION_QUEUE_SIZE 0
 
+//
+// IOTLB invalidation granularity, as encoded in the IOTLB invalidate
+// descriptor (the IOTLB register uses the same values in its IIRG field).
+//
+#define VTD_INVALIDATION_GRANULARITY_GLOBAL 1
+#define VTD_INVALIDATION_GRANULARITY_DOMAIN 2
+#define VTD_INVALIDATION_GRANULARITY_PAGE   3
+
+//
+// Max number of page ranges that may wait for a page-selective IOTLB invalidation.
+// Max number of invalidate descriptors submitted to the invalidation queue at once.
+//
+#define VTD_PENDING_INVALIDATION_NUMBER     8
+#define VTD_INVALIDATION_BATCH_SIZE         16
+
+//
+// Max number of page tables, merged into large pages, that wait for the
+// IOTLB invalidation before being freed.
+//
+#define VTD_PENDING_FREE_PAGE_TABLE_NUMBER  16
+
 //
 // This is the initial max PCI DATA number.
 // The number may be enlarged later.
@@ -74,6 +95,19 @@ typedef struct {
   PCI_DEVICE_DATA                  *PciDeviceData;
 } PCI_DEVICE_INFORMATION;
 
+typedef struct {
+  UINT16                           DomainIdentifier;
+  UINT64                           BaseAddress;
+  UINT64                           Length;
+} VTD_PENDING_INVALIDATION;
+
+typedef struct {
+  UINTN                            GlobalInvalidations;
+  UINTN                            DomainInvalidations;
+  UINTN                            PageInvalidations;
+  UINTN                            QueuedSubmissions;
+} VTD_INVALIDATION_STATISTICS;
+
 typedef struct {
   UINTN                            VtdUnitBaseAddress;
   UINT16                           Segment;
@@ -90,6 +124,12 @@ typedef struct {
   UINT8                            EnableQueuedInvalidation;
   VOID                             *QiDescBuffer;
   UINTN                            QiDescBufferSize;
+  UINTN                            PendingInvalidationNumber;
+  BOOLEAN                          PendingInvalidationOverflow;
+  VTD_PENDING_INVALIDATION         PendingInvalidation[VTD_PENDING_INVALIDATION_NUMBER];
+  VTD_INVALIDATION_STATISTICS      InvalidationStatistics;
+  UINTN                            PendingFreePageTableNumber;
+  VOID                             *PendingFreePageTable[VTD_PENDING_FREE_PAGE_TABLE_NUMBER];
 } VTD_UNIT_INFORMATION;
 
 //
@@ -135,6 +175,8 @@ extern EFI_ACPI_DMAR_HEADER  *mAcpiDmarTable;
 extern UINTN                            mVtdUnitNumber;
 extern VTD_UNIT_INFORMATION             *mVtdUnitInformation;
 
+extern UINTN                            mVtdTranslationTablePages;
+
 extern UINT64                           mBelow4GMemoryLimit;
 extern UINT64                           mAbove4GMemoryLimit;
 
@@ -238,6 +280,50 @@ InvalidateVtdIOTLBGlobal (
   IN UINTN  VtdIndex
   );
 
+/**
+  Record a range of pages whose second level paging entries were modified,
+  so that the next InvalidateVtdIOTLBPages() invalidates them.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+  @param[in]  DomainIdentifier      The domain ID of the pages.
+  @param[in]  BaseAddress           The base address of the pages.
+  @param[in]  Length                The length of the pages.
+**/
+VOID
+AddPendingPageInvalidation (
+  IN UINTN   VtdIndex,
+  IN UINT16  DomainIdentifier,
+  IN UINT64  BaseAddress,
+  IN UINT64  Length
+  );
+
+/**
+  Invalidate the VTd IOTLB entries of the pending page ranges.
+
+  Page-selective invalidation is used if the hardware supports it and the
+  number of invalidations fits in one batch. Otherwise, domain-selective
+  invalidation is used, and global invalidation as last resort.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+
+  @retval EFI_SUCCESS           VTd IOTLB is invalidated.
+  @retval EFI_DEVICE_ERROR      VTd IOTLB is not invalidated.
+**/
+EFI_STATUS
+InvalidateVtdIOTLBPages (
+  IN UINTN  VtdIndex
+  );
+
+/**
+  Dump the VTd IOTLB invalidation statistics.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+**/
+VOID
+DumpVtdInvalidationStatistics (
+  IN UINTN  VtdIndex
+  );
+
 /**
   Dump VTd registers.
 
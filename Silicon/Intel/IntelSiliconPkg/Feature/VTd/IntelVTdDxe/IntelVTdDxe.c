@@ -107,6 +107,14 @@ IoMmuFreeBuffer (
   IN  VOID                                     *HostAddress
   );
 
+/**
+  Initialize the mapping hash tables and pre-allocate the bounce buffer pool.
+**/
+VOID
+InitializeBmDma (
+  VOID
+  );
+
 /**
   This function fills DeviceHandle/IoMmuAccess to the MAP_HANDLE_INFO,
   based upon the DeviceAddress.
@@ -388,6 +396,8 @@ IntelVTdInitialize (
 
   InitializeDmaProtection ();
 
+  InitializeBmDma ();
+
   Handle = NULL;
   Status = gBS->InstallMultipleProtocolInterfaces (
                   &Handle,
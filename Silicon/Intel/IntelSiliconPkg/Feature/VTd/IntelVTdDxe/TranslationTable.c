@@ -7,6 +7,11 @@
 
 #include "DmaProtection.h"
 
+//
+// Number of pages used by the VTd translation tables.
+//
+UINTN  mVtdTranslationTablePages;
+
 /**
   Create extended context entry.
 
@@ -41,6 +46,7 @@ AllocateZeroPages (
     return NULL;
   }
   ZeroMem (Addr, EFI_PAGES_TO_SIZE(Pages));
+  mVtdTranslationTablePages += Pages;
   return Addr;
 }
 
@@ -192,13 +198,23 @@ CreateSecondLevelPagingEntryTable (
   VTD_SECOND_LEVEL_PAGING_ENTRY  *Lvl4PtEntry;
   VTD_SECOND_LEVEL_PAGING_ENTRY  *Lvl3PtEntry;
   VTD_SECOND_LEVEL_PAGING_ENTRY  *Lvl2PtEntry;
+  VTD_SECOND_LEVEL_PAGING_ENTRY  *Lvl1PtEntry;
+  UINTN                          Index1;
   UINT64                         BaseAddress;
   UINT64                         EndAddress;
+  BOOLEAN                        Use1GPage;
+  BOOLEAN                        Use2MPage;
 
   if (MemoryLimit == 0) {
     return NULL;
   }
 
+  //
+  // Use the largest page size supported by the engine.
+  //
+  Use1GPage = ((mVtdUnitInformation[VtdIndex].CapReg.Bits.SLLPS & BIT1) != 0);
+  Use2MPage = ((mVtdUnitInformation[VtdIndex].CapReg.Bits.SLLPS & BIT0) != 0);
+
   Lvl4PagesStart = 0;
   Lvl4PagesEnd   = 0;
   Lvl4PtEntry    = NULL;
@@ -293,6 +309,29 @@ CreateSecondLevelPagingEntryTable (
 
       Lvl3PtEntry = (VTD_SECOND_LEVEL_PAGING_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(Lvl4PtEntry[Index4].Bits.AddressLo, Lvl4PtEntry[Index4].Bits.AddressHi);
       for (Index3 = Lvl3Start; Index3 <= Lvl3End; Index3++) {
+        if (Lvl3PtEntry[Index3].Bits.PageSize != 0) {
+          //
+          // Already mapped by a 1G page.
+          //
+          BaseAddress = ALIGN_VALUE_LOW(BaseAddress, SIZE_1GB) + SIZE_1GB;
+          if (BaseAddress >= MemoryLimit) {
+            break;
+          }
+          continue;
+        }
+
+        if (Use1GPage && (Lvl3PtEntry[Index3].Uint64 == 0) &&
+            ((BaseAddress & PAGING_1G_MASK) == 0) && (BaseAddress + SIZE_1GB <= EndAddress)) {
+          Lvl3PtEntry[Index3].Uint64 = BaseAddress;
+          SetSecondLevelPagingEntryAttribute (&Lvl3PtEntry[Index3], IoMmuAccess);
+          Lvl3PtEntry[Index3].Bits.PageSize = 1;
+          BaseAddress += SIZE_1GB;
+          if (BaseAddress >= MemoryLimit) {
+            break;
+          }
+          continue;
+        }
+
         if (Lvl3PtEntry[Index3].Uint64 == 0) {
           Lvl3PtEntry[Index3].Uint64 = (UINT64)(UINTN)AllocateZeroPages (1);
           if (Lvl3PtEntry[Index3].Uint64 == 0) {
@@ -306,9 +345,25 @@ CreateSecondLevelPagingEntryTable (
 
         Lvl2PtEntry = (VTD_SECOND_LEVEL_PAGING_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(Lvl3PtEntry[Index3].Bits.AddressLo, Lvl3PtEntry[Index3].Bits.AddressHi);
         for (Index2 = 0; Index2 < SIZE_4KB/sizeof(VTD_SECOND_LEVEL_PAGING_ENTRY); Index2++) {
-          Lvl2PtEntry[Index2].Uint64 = BaseAddress;
-          SetSecondLevelPagingEntryAttribute (&Lvl2PtEntry[Index2], IoMmuAccess);
-          Lvl2PtEntry[Index2].Bits.PageSize = 1;
+          if (Use2MPage) {
+            Lvl2PtEntry[Index2].Uint64 = BaseAddress;
+            SetSecondLevelPagingEntryAttribute (&Lvl2PtEntry[Index2], IoMmuAccess);
+            Lvl2PtEntry[Index2].Bits.PageSize = 1;
+          } else {
+            Lvl1PtEntry = AllocateZeroPages (1);
+            if (Lvl1PtEntry == NULL) {
+              DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL1 PAGE FAIL (0x%x, 0x%x, 0x%x)!!!!!!\n", Index4, Index3, Index2));
+              ASSERT(FALSE);
+              return NULL;
+            }
+            for (Index1 = 0; Index1 < SIZE_4KB/sizeof(VTD_SECOND_LEVEL_PAGING_ENTRY); Index1++) {
+              Lvl1PtEntry[Index1].Uint64 = BaseAddress + SIZE_4KB * Index1;
+              SetSecondLevelPagingEntryAttribute (&Lvl1PtEntry[Index1], IoMmuAccess);
+            }
+            FlushPageTableMemory (VtdIndex, (UINTN)Lvl1PtEntry, SIZE_4KB);
+            Lvl2PtEntry[Index2].Uint64 = (UINT64)(UINTN)Lvl1PtEntry;
+            SetSecondLevelPagingEntryAttribute (&Lvl2PtEntry[Index2], EDKII_IOMMU_ACCESS_READ | EDKII_IOMMU_ACCESS_WRITE);
+          }
           BaseAddress += SIZE_2MB;
           if (BaseAddress >= MemoryLimit) {
             break;
@@ -547,11 +602,30 @@ InvalidatePageEntry (
   IN UINTN                 VtdIndex
   )
 {
-  if (mVtdUnitInformation[VtdIndex].HasDirtyContext || mVtdUnitInformation[VtdIndex].HasDirtyPages) {
+  UINTN  Index;
+
+  if (mVtdUnitInformation[VtdIndex].HasDirtyContext) {
     InvalidateVtdIOTLBGlobal (VtdIndex);
+  } else if (mVtdUnitInformation[VtdIndex].HasDirtyPages) {
+    //
+    // Only the pages modified since the last invalidation need to be invalidated.
+    //
+    InvalidateVtdIOTLBPages (VtdIndex);
   }
   mVtdUnitInformation[VtdIndex].HasDirtyContext = FALSE;
   mVtdUnitInformation[VtdIndex].HasDirtyPages = FALSE;
+  mVtdUnitInformation[VtdIndex].PendingInvalidationNumber = 0;
+  mVtdUnitInformation[VtdIndex].PendingInvalidationOverflow = FALSE;
+
+  //
+  // The page tables replaced by large pages can only be freed once
+  // the engine no longer caches them.
+  //
+  for (Index = 0; Index < mVtdUnitInformation[VtdIndex].PendingFreePageTableNumber; Index++) {
+    FreePages (mVtdUnitInformation[VtdIndex].PendingFreePageTable[Index], 1);
+    mVtdTranslationTablePages--;
+  }
+  mVtdUnitInformation[VtdIndex].PendingFreePageTableNumber = 0;
 }
 
 #define VTD_PG_R                   BIT0
@@ -614,6 +688,27 @@ PageAttributeToLength (
   return 0;
 }
 
+/**
+  Return the largest page supported by the second level translation of a VTd engine.
+
+  @param[in]  VtdIndex         The index used to identify a VTd engine.
+
+  @return The page attribute of the largest page.
+**/
+PAGE_ATTRIBUTE
+GetMaxPageAttribute (
+  IN UINTN  VtdIndex
+  )
+{
+  if ((mVtdUnitInformation[VtdIndex].CapReg.Bits.SLLPS & BIT1) != 0) {
+    return Page1G;
+  }
+  if ((mVtdUnitInformation[VtdIndex].CapReg.Bits.SLLPS & BIT0) != 0) {
+    return Page2M;
+  }
+  return Page4K;
+}
+
 /**
   Return page table entry to match the address.
 
@@ -868,6 +963,110 @@ SplitSecondLevelPage (
   }
 }
 
+/**
+  This function merges the page table mapping an address into one large page
+  entry, if all the entries of the page table map contiguous memory with the
+  same attributes. This typically happens once the access to the DMA buffers
+  which caused a large page to be split is revoked.
+
+  The page table is freed by InvalidatePageEntry(), after the IOTLB invalidation.
+
+  @param[in]  VtdIndex                The index used to identify a VTd engine.
+  @param[in]  DomainIdentifier        The domain ID of the source.
+  @param[in]  SecondLevelPagingEntry  The second level paging entry in VTd table for the device.
+  @param[in]  Address                 The address mapped by the page table.
+  @param[in]  MergeAttribute          Page2M to merge a 4K page table, Page1G to merge a 2M page table.
+**/
+VOID
+MergeSecondLevelPage (
+  IN UINTN                          VtdIndex,
+  IN UINT16                         DomainIdentifier,
+  IN VTD_SECOND_LEVEL_PAGING_ENTRY  *SecondLevelPagingEntry,
+  IN PHYSICAL_ADDRESS               Address,
+  IN PAGE_ATTRIBUTE                 MergeAttribute
+  )
+{
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+  UINT64                *PageTable;
+  UINT64                *PageEntry;
+  UINT64                PageLength;
+  UINT64                SubPageLength;
+  UINT64                SubPageAddressMask;
+  UINT64                EntryAttributes;
+  UINTN                 Index;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+  if ((MergeAttribute > GetMaxPageAttribute (VtdIndex)) ||
+      (VTdUnitInfo->PendingFreePageTableNumber == VTD_PENDING_FREE_PAGE_TABLE_NUMBER)) {
+    return;
+  }
+
+  PageLength = PageAttributeToLength (MergeAttribute);
+  Address = Address & ~(PageLength - 1);
+
+  //
+  // Find the entry pointing to the page table, without creating any missing table.
+  //
+  PageTable = (UINT64 *)SecondLevelPagingEntry;
+  if (VTdUnitInfo->Is5LevelPaging) {
+    PageEntry = &PageTable[RShiftU64 (Address, 48) & PAGING_VTD_INDEX_MASK];
+    if (*PageEntry == 0) {
+      return;
+    }
+    PageTable = (UINT64 *)(UINTN)(*PageEntry & PAGING_4K_ADDRESS_MASK_64);
+  }
+
+  PageEntry = &PageTable[RShiftU64 (Address, 39) & PAGING_VTD_INDEX_MASK];
+  if (*PageEntry == 0) {
+    return;
+  }
+  PageTable = (UINT64 *)(UINTN)(*PageEntry & PAGING_4K_ADDRESS_MASK_64);
+
+  PageEntry = &PageTable[RShiftU64 (Address, 30) & PAGING_VTD_INDEX_MASK];
+  if (MergeAttribute == Page2M) {
+    if ((*PageEntry == 0) || ((*PageEntry & VTD_PG_PS) != 0)) {
+      return;
+    }
+    PageTable = (UINT64 *)(UINTN)(*PageEntry & PAGING_4K_ADDRESS_MASK_64);
+    PageEntry = &PageTable[RShiftU64 (Address, 21) & PAGING_VTD_INDEX_MASK];
+  }
+
+  //
+  // Nothing to merge if it is not present, or already a large page.
+  //
+  if ((*PageEntry == 0) || ((*PageEntry & VTD_PG_PS) != 0)) {
+    return;
+  }
+
+  if (MergeAttribute == Page2M) {
+    SubPageLength = SIZE_4KB;
+    SubPageAddressMask = PAGING_4K_ADDRESS_MASK_64;
+  } else {
+    SubPageLength = SIZE_2MB;
+    SubPageAddressMask = PAGING_2M_ADDRESS_MASK_64;
+  }
+
+  PageTable = (UINT64 *)(UINTN)(*PageEntry & PAGING_4K_ADDRESS_MASK_64);
+  EntryAttributes = PageTable[0] & ~SubPageAddressMask;
+  if ((MergeAttribute == Page1G) && ((EntryAttributes & VTD_PG_PS) == 0)) {
+    return;
+  }
+  for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
+    if (((PageTable[Index] & SubPageAddressMask) != Address + SubPageLength * Index) ||
+        ((PageTable[Index] & ~SubPageAddressMask) != EntryAttributes)) {
+      return;
+    }
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "Merge - 0x%x (0x%lx)\n", PageTable, Address));
+  *PageEntry = Address | EntryAttributes | VTD_PG_PS;
+  FlushPageTableMemory (VtdIndex, (UINTN)PageEntry, sizeof(*PageEntry));
+
+  AddPendingPageInvalidation (VtdIndex, DomainIdentifier, Address, PageLength);
+  VTdUnitInfo->PendingFreePageTable[VTdUnitInfo->PendingFreePageTableNumber] = PageTable;
+  VTdUnitInfo->PendingFreePageTableNumber++;
+}
+
 /**
   Set VTd attribute for a system memory on second level page entry
 
@@ -902,8 +1101,12 @@ SetSecondLevelPagingAttribute (
   PAGE_ATTRIBUTE                 PageAttribute;
   UINTN                          PageEntryLength;
   PAGE_ATTRIBUTE                 SplitAttribute;
+  PAGE_ATTRIBUTE                 MaxPageAttribute;
   EFI_STATUS                     Status;
   BOOLEAN                        IsEntryModified;
+  UINT64                         StartAddress;
+  UINT64                         EndAddress;
+  UINT64                         Address;
 
   DEBUG ((DEBUG_VERBOSE,"SetSecondLevelPagingAttribute (%d) (0x%016lx - 0x%016lx : %x) \n", VtdIndex, BaseAddress, Length, IoMmuAccess));
   DEBUG ((DEBUG_VERBOSE,"  SecondLevelPagingEntry Base - 0x%x\n", SecondLevelPagingEntry));
@@ -917,6 +1120,10 @@ SetSecondLevelPagingAttribute (
     return EFI_UNSUPPORTED;
   }
 
+  StartAddress = BaseAddress;
+  EndAddress = BaseAddress + Length;
+  MaxPageAttribute = GetMaxPageAttribute (VtdIndex);
+
   while (Length != 0) {
     PageEntry = GetSecondLevelPageTableEntry (VtdIndex, SecondLevelPagingEntry, BaseAddress, mVtdUnitInformation[VtdIndex].Is5LevelPaging, &PageAttribute);
     if (PageEntry == NULL) {
@@ -925,10 +1132,16 @@ SetSecondLevelPagingAttribute (
     }
     PageEntryLength = PageAttributeToLength (PageAttribute);
     SplitAttribute = NeedSplitPage (BaseAddress, Length, PageAttribute);
+    if ((SplitAttribute == PageNone) && (PageAttribute > MaxPageAttribute)) {
+      //
+      // The engine does not support this page size, so it must not be made present.
+      //
+      SplitAttribute = (PageAttribute == Page1G) ? Page2M : Page4K;
+    }
     if (SplitAttribute == PageNone) {
       ConvertSecondLevelPageEntryAttribute (VtdIndex, PageEntry, IoMmuAccess, &IsEntryModified);
       if (IsEntryModified) {
-        mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
+        AddPendingPageInvalidation (VtdIndex, DomainIdentifier, BaseAddress, PageEntryLength);
       }
       //
       // Convert success, move to next
@@ -941,7 +1154,7 @@ SetSecondLevelPagingAttribute (
         DEBUG ((DEBUG_ERROR, "SplitSecondLevelPage - %r\n", Status));
         return RETURN_UNSUPPORTED;
       }
-      mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
+      AddPendingPageInvalidation (VtdIndex, DomainIdentifier, BaseAddress & ~((UINT64)PageEntryLength - 1), PageEntryLength);
       //
       // Just split current page
       // Convert success in next around
@@ -949,6 +1162,16 @@ SetSecondLevelPagingAttribute (
     }
   }
 
+  //
+  // Merge the page tables covering the range back into large pages where possible.
+  //
+  for (Address = ALIGN_VALUE_LOW(StartAddress, SIZE_2MB); Address < EndAddress; Address += SIZE_2MB) {
+    MergeSecondLevelPage (VtdIndex, DomainIdentifier, SecondLevelPagingEntry, Address, Page2M);
+  }
+  for (Address = ALIGN_VALUE_LOW(StartAddress, SIZE_1GB); Address < EndAddress; Address += SIZE_1GB) {
+    MergeSecondLevelPage (VtdIndex, DomainIdentifier, SecondLevelPagingEntry, Address, Page1G);
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -208,20 +208,22 @@ QueuedInvalidationCheckFault (
 }
 
 /**
-  Submit the queued invalidation descriptor to the remapping
-   hardware unit and wait for its completion.
+  Submit a batch of queued invalidation descriptors to the remapping
+   hardware unit and wait for their completion.
 
   @param[in]  VtdIndex          The index used to identify a VTd engine.
-  @param[in]  Desc              The invalidate descriptor
+  @param[in]  Desc              The invalidate descriptors
+  @param[in]  DescNumber        The number of invalidate descriptors
 
   @retval EFI_SUCCESS           The operation was successful.
   @retval RETURN_DEVICE_ERROR   A fault is detected.
   @retval EFI_INVALID_PARAMETER Parameter is invalid.
 **/
 EFI_STATUS
-SubmitQueuedInvalidationDescriptor (
+SubmitQueuedInvalidationDescriptors (
   IN UINTN        VtdIndex,
-  IN QI_256_DESC  *Desc
+  IN QI_256_DESC  *Desc,
+  IN UINTN        DescNumber
   )
 {
   EFI_STATUS     Status;
@@ -229,13 +231,14 @@ SubmitQueuedInvalidationDescriptor (
   UINTN          QueueSize;
   UINTN          QueueTail;
   UINTN          QueueHead;
+  UINTN          Index;
   QI_DESC        *Qi128Desc;
   QI_256_DESC    *Qi256Desc;
   VTD_IQA_REG    IqaReg;
   VTD_IQT_REG    IqtReg;
   VTD_IQH_REG    IqhReg;
 
-  if (Desc == NULL) {
+  if ((Desc == NULL) || (DescNumber == 0)) {
     return EFI_INVALID_PARAMETER;
   }
 
@@ -248,55 +251,72 @@ SubmitQueuedInvalidationDescriptor (
   IqtReg.Uint64 = MmioRead64 (VtdUnitBaseAddress + R_IQT_REG);
 
   if (IqaReg.Bits.DW == 0) {
-    //
-    // 128-bit descriptor
-    //
     QueueSize = (UINTN) (1 << (IqaReg.Bits.QS + 8));
-    Qi128Desc = (QI_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
     QueueTail = (UINTN) IqtReg.Bits128Desc.QT;
-    Qi128Desc += QueueTail;
-    Qi128Desc->Low = Desc->Uint64[0];
-    Qi128Desc->High = Desc->Uint64[1];
-    FlushPageTableMemory (VtdIndex, (UINTN) Qi128Desc, sizeof(QI_DESC));
-    QueueTail = (QueueTail + 1) % QueueSize;
-
-    DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx]\n",
-            VtdUnitBaseAddress,
-            QueueTail,
-            Desc->Uint64[0],
-            Desc->Uint64[1]));
-
-    IqtReg.Bits128Desc.QT = QueueTail;
   } else {
-    //
-    // 256-bit descriptor
-    //
     QueueSize = (UINTN) (1 << (IqaReg.Bits.QS + 7));
-    Qi256Desc = (QI_256_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
     QueueTail = (UINTN) IqtReg.Bits256Desc.QT;
-    Qi256Desc += QueueTail;
-    Qi256Desc->Uint64[0] = Desc->Uint64[0];
-    Qi256Desc->Uint64[1] = Desc->Uint64[1];
-    Qi256Desc->Uint64[2] = Desc->Uint64[2];
-    Qi256Desc->Uint64[3] = Desc->Uint64[3];
-    FlushPageTableMemory (VtdIndex, (UINTN) Qi256Desc, sizeof(QI_256_DESC));
-    QueueTail = (QueueTail + 1) % QueueSize;
-
-    DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx, 0x%016lx, 0x%016lx]\n",
-            VtdUnitBaseAddress,
-            QueueTail,
-            Desc->Uint64[0],
-            Desc->Uint64[1],
-            Desc->Uint64[2],
-            Desc->Uint64[3]));
+  }
+
+  //
+  // The queue is empty when we get here, as every submission waits for its completion.
+  //
+  if (DescNumber >= QueueSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < DescNumber; Index++) {
+    if (IqaReg.Bits.DW == 0) {
+      //
+      // 128-bit descriptor
+      //
+      Qi128Desc = (QI_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
+      Qi128Desc += QueueTail;
+      Qi128Desc->Low = Desc[Index].Uint64[0];
+      Qi128Desc->High = Desc[Index].Uint64[1];
+      FlushPageTableMemory (VtdIndex, (UINTN) Qi128Desc, sizeof(QI_DESC));
+      QueueTail = (QueueTail + 1) % QueueSize;
+
+      DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx]\n",
+              VtdUnitBaseAddress,
+              QueueTail,
+              Desc[Index].Uint64[0],
+              Desc[Index].Uint64[1]));
+    } else {
+      //
+      // 256-bit descriptor
+      //
+      Qi256Desc = (QI_256_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
+      Qi256Desc += QueueTail;
+      Qi256Desc->Uint64[0] = Desc[Index].Uint64[0];
+      Qi256Desc->Uint64[1] = Desc[Index].Uint64[1];
+      Qi256Desc->Uint64[2] = Desc[Index].Uint64[2];
+      Qi256Desc->Uint64[3] = Desc[Index].Uint64[3];
+      FlushPageTableMemory (VtdIndex, (UINTN) Qi256Desc, sizeof(QI_256_DESC));
+      QueueTail = (QueueTail + 1) % QueueSize;
+
+      DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx, 0x%016lx, 0x%016lx]\n",
+              VtdUnitBaseAddress,
+              QueueTail,
+              Desc[Index].Uint64[0],
+              Desc[Index].Uint64[1],
+              Desc[Index].Uint64[2],
+              Desc[Index].Uint64[3]));
+    }
+  }
 
+  if (IqaReg.Bits.DW == 0) {
+    IqtReg.Bits128Desc.QT = QueueTail;
+  } else {
     IqtReg.Bits256Desc.QT = QueueTail;
   }
 
   //
   // Update the HW tail register indicating the presence of new descriptors.
+  // The whole batch is handed over to the hardware with a single write.
   //
   MmioWrite64 (VtdUnitBaseAddress + R_IQT_REG, IqtReg.Uint64);
+  mVtdUnitInformation[VtdIndex].InvalidationStatistics.QueuedSubmissions++;
 
   Status = EFI_SUCCESS;
   do {
@@ -317,6 +337,26 @@ SubmitQueuedInvalidationDescriptor (
   return Status;
 }
 
+/**
+  Submit the queued invalidation descriptor to the remapping
+   hardware unit and wait for its completion.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+  @param[in]  Desc              The invalidate descriptor
+
+  @retval EFI_SUCCESS           The operation was successful.
+  @retval RETURN_DEVICE_ERROR   A fault is detected.
+  @retval EFI_INVALID_PARAMETER Parameter is invalid.
+**/
+EFI_STATUS
+SubmitQueuedInvalidationDescriptor (
+  IN UINTN        VtdIndex,
+  IN QI_256_DESC  *Desc
+  )
+{
+  return SubmitQueuedInvalidationDescriptors (VtdIndex, Desc, 1);
+}
+
 /**
   Invalidate VTd context cache.
 
@@ -374,6 +414,8 @@ InvalidateIOTLB (
   UINT64         Reg64;
   QI_256_DESC    QiDesc;
 
+  mVtdUnitInformation[VtdIndex].InvalidationStatistics.GlobalInvalidations++;
+
   if (mVtdUnitInformation[VtdIndex].EnableQueuedInvalidation == 0) {
     //
     // Register-based Invalidation
@@ -447,6 +489,331 @@ InvalidateVtdIOTLBGlobal (
   return EFI_SUCCESS;
 }
 
+/**
+  Record a range of pages whose second level paging entries were modified,
+  so that the next InvalidateVtdIOTLBPages() invalidates them.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+  @param[in]  DomainIdentifier      The domain ID of the pages.
+  @param[in]  BaseAddress           The base address of the pages.
+  @param[in]  Length                The length of the pages.
+**/
+VOID
+AddPendingPageInvalidation (
+  IN UINTN   VtdIndex,
+  IN UINT16  DomainIdentifier,
+  IN UINT64  BaseAddress,
+  IN UINT64  Length
+  )
+{
+  VTD_UNIT_INFORMATION      *VTdUnitInfo;
+  VTD_PENDING_INVALIDATION  *Pending;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+  VTdUnitInfo->HasDirtyPages = TRUE;
+
+  if (VTdUnitInfo->PendingInvalidationOverflow) {
+    return;
+  }
+
+  //
+  // Pages are usually modified in ascending order, so try to extend the last range.
+  //
+  if (VTdUnitInfo->PendingInvalidationNumber != 0) {
+    Pending = &VTdUnitInfo->PendingInvalidation[VTdUnitInfo->PendingInvalidationNumber - 1];
+    if ((Pending->DomainIdentifier == DomainIdentifier) &&
+        (Pending->BaseAddress + Pending->Length == BaseAddress)) {
+      Pending->Length += Length;
+      return;
+    }
+  }
+
+  if (VTdUnitInfo->PendingInvalidationNumber == VTD_PENDING_INVALIDATION_NUMBER) {
+    VTdUnitInfo->PendingInvalidationOverflow = TRUE;
+    return;
+  }
+
+  Pending = &VTdUnitInfo->PendingInvalidation[VTdUnitInfo->PendingInvalidationNumber];
+  Pending->DomainIdentifier = DomainIdentifier;
+  Pending->BaseAddress = BaseAddress;
+  Pending->Length = Length;
+  VTdUnitInfo->PendingInvalidationNumber++;
+}
+
+/**
+  Get the largest address mask usable to invalidate the pages at the beginning of a range.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+  @param[in]  BaseAddress           The base address of the range.
+  @param[in]  PageNumber            The number of 4KB pages in the range.
+
+  @return The address mask, i.e. the range invalidated is 2^AddressMask pages.
+**/
+STATIC
+UINT8
+GetPageInvalidationAddressMask (
+  IN UINTN   VtdIndex,
+  IN UINT64  BaseAddress,
+  IN UINT64  PageNumber
+  )
+{
+  UINT8  AddressMask;
+
+  //
+  // The address must be naturally aligned to the size of the invalidated range.
+  //
+  AddressMask = 0;
+  while ((AddressMask < mVtdUnitInformation[VtdIndex].CapReg.Bits.MAMV) &&
+         (LShiftU64 (2, AddressMask) <= PageNumber) &&
+         ((RShiftU64 (BaseAddress, VTD_PAGE_SHIFT) & (LShiftU64 (2, AddressMask) - 1)) == 0)) {
+    AddressMask++;
+  }
+
+  return AddressMask;
+}
+
+/**
+  Get the granularity used to invalidate the pending page ranges.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+
+  @return VTD_INVALIDATION_GRANULARITY_PAGE, VTD_INVALIDATION_GRANULARITY_DOMAIN
+          or VTD_INVALIDATION_GRANULARITY_GLOBAL.
+**/
+STATIC
+UINT8
+GetPendingInvalidationGranularity (
+  IN UINTN  VtdIndex
+  )
+{
+  VTD_UNIT_INFORMATION      *VTdUnitInfo;
+  VTD_PENDING_INVALIDATION  *Pending;
+  UINTN                     Index;
+  UINTN                     InvalidationNumber;
+  UINT64                    Address;
+  UINT64                    PageNumber;
+  UINT8                     AddressMask;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  if (VTdUnitInfo->PendingInvalidationOverflow) {
+    return VTD_INVALIDATION_GRANULARITY_GLOBAL;
+  }
+
+  if (VTdUnitInfo->CapReg.Bits.PSI == 0) {
+    return VTD_INVALIDATION_GRANULARITY_DOMAIN;
+  }
+
+  InvalidationNumber = 0;
+  for (Index = 0; Index < VTdUnitInfo->PendingInvalidationNumber; Index++) {
+    Pending = &VTdUnitInfo->PendingInvalidation[Index];
+    Address = Pending->BaseAddress;
+    PageNumber = RShiftU64 (Pending->Length, VTD_PAGE_SHIFT);
+    while (PageNumber != 0) {
+      InvalidationNumber++;
+      if (InvalidationNumber > VTD_INVALIDATION_BATCH_SIZE) {
+        return VTD_INVALIDATION_GRANULARITY_DOMAIN;
+      }
+      AddressMask = GetPageInvalidationAddressMask (VtdIndex, Address, PageNumber);
+      Address += LShiftU64 (SIZE_4KB, AddressMask);
+      PageNumber -= LShiftU64 (1, AddressMask);
+    }
+  }
+
+  return VTD_INVALIDATION_GRANULARITY_PAGE;
+}
+
+/**
+  Invalidate the VTd IOTLB entries of a domain, or of a range of pages in a domain.
+
+  With register-based invalidation, the invalidation is done before returning.
+  With queued invalidation, the invalidate descriptor is appended to Desc, and
+  is submitted by the caller together with the rest of the batch.
+
+  @param[in]      VtdIndex          The index of VTd engine.
+  @param[in]      Granularity       VTD_INVALIDATION_GRANULARITY_DOMAIN or VTD_INVALIDATION_GRANULARITY_PAGE.
+  @param[in]      DomainIdentifier  The domain ID.
+  @param[in]      Address           The base address of the pages, for page-selective invalidation.
+  @param[in]      AddressMask       The address mask of the pages, for page-selective invalidation.
+  @param[in, out] Desc              The batch of invalidate descriptors.
+  @param[in, out] DescNumber        The number of invalidate descriptors in the batch.
+
+  @retval EFI_SUCCESS           The invalidation is done, or queued in the batch.
+  @retval EFI_DEVICE_ERROR      The IOTLB register is busy.
+**/
+STATIC
+EFI_STATUS
+AddIOTLBInvalidation (
+  IN     UINTN        VtdIndex,
+  IN     UINT8        Granularity,
+  IN     UINT16       DomainIdentifier,
+  IN     UINT64       Address,
+  IN     UINT8        AddressMask,
+  IN OUT QI_256_DESC  *Desc,
+  IN OUT UINTN        *DescNumber
+  )
+{
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+  UINTN                 IotlbRegBase;
+  UINT64                Reg64;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  if (Granularity == VTD_INVALIDATION_GRANULARITY_PAGE) {
+    VTdUnitInfo->InvalidationStatistics.PageInvalidations++;
+  } else {
+    VTdUnitInfo->InvalidationStatistics.DomainInvalidations++;
+  }
+
+  if (VTdUnitInfo->EnableQueuedInvalidation == 0) {
+    //
+    // Register-based Invalidation
+    //
+    IotlbRegBase = VTdUnitInfo->VtdUnitBaseAddress + (VTdUnitInfo->ECapReg.Bits.IRO * 16);
+    Reg64 = MmioRead64 (IotlbRegBase + R_IOTLB_REG);
+    if ((Reg64 & B_IOTLB_REG_IVT) != 0) {
+      DEBUG ((DEBUG_ERROR,"ERROR: AddIOTLBInvalidation: B_IOTLB_REG_IVT is set for VTD(%d)\n", VtdIndex));
+      return EFI_DEVICE_ERROR;
+    }
+
+    if (Granularity == VTD_INVALIDATION_GRANULARITY_PAGE) {
+      MmioWrite64 (IotlbRegBase + R_IVA_REG, (Address & VTD_PAGE_MASK) | AddressMask);
+      Reg64 = V_IOTLB_REG_IIRG_PAGE;
+    } else {
+      Reg64 = V_IOTLB_REG_IIRG_DOMAIN;
+    }
+    Reg64 |= B_IOTLB_REG_IVT | LShiftU64 (DomainIdentifier, 32);
+    MmioWrite64 (IotlbRegBase + R_IOTLB_REG, Reg64);
+
+    do {
+      Reg64 = MmioRead64 (IotlbRegBase + R_IOTLB_REG);
+    } while ((Reg64 & B_IOTLB_REG_IVT) != 0);
+  } else {
+    //
+    // Queued Invalidation
+    //
+    ASSERT (*DescNumber < VTD_INVALIDATION_BATCH_SIZE);
+    Desc[*DescNumber].Uint64[0] = QI_IOTLB_DID(DomainIdentifier) | QI_IOTLB_DR(CAP_READ_DRAIN(VTdUnitInfo->CapReg.Uint64)) | QI_IOTLB_DW(CAP_WRITE_DRAIN(VTdUnitInfo->CapReg.Uint64)) | QI_IOTLB_GRAN(Granularity) | QI_IOTLB_TYPE;
+    Desc[*DescNumber].Uint64[1] = QI_IOTLB_ADDR(Address) | QI_IOTLB_IH(0) | QI_IOTLB_AM(AddressMask);
+    Desc[*DescNumber].Uint64[2] = 0;
+    Desc[*DescNumber].Uint64[3] = 0;
+    (*DescNumber)++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Invalidate the VTd IOTLB entries of the pending page ranges.
+
+  Page-selective invalidation is used if the hardware supports it and the
+  number of invalidations fits in one batch. Otherwise, domain-selective
+  invalidation is used, and global invalidation as last resort.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+
+  @retval EFI_SUCCESS           VTd IOTLB is invalidated.
+  @retval EFI_DEVICE_ERROR      VTd IOTLB is not invalidated.
+**/
+EFI_STATUS
+InvalidateVtdIOTLBPages (
+  IN UINTN  VtdIndex
+  )
+{
+  EFI_STATUS                Status;
+  VTD_UNIT_INFORMATION      *VTdUnitInfo;
+  VTD_PENDING_INVALIDATION  *Pending;
+  QI_256_DESC               QiDesc[VTD_INVALIDATION_BATCH_SIZE];
+  UINTN                     DescNumber;
+  UINTN                     Index;
+  UINTN                     Index2;
+  UINT8                     Granularity;
+  UINT64                    Address;
+  UINT64                    PageNumber;
+  UINT8                     AddressMask;
+
+  if (!mVtdEnabled) {
+    return EFI_SUCCESS;
+  }
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  DEBUG((DEBUG_VERBOSE, "InvalidateVtdIOTLBPages(%d) - %d ranges\n", VtdIndex, VTdUnitInfo->PendingInvalidationNumber));
+
+  //
+  // Write Buffer Flush before invalidation
+  //
+  FlushWriteBuffer (VtdIndex);
+
+  Granularity = GetPendingInvalidationGranularity (VtdIndex);
+  if (Granularity == VTD_INVALIDATION_GRANULARITY_GLOBAL) {
+    return InvalidateIOTLB (VtdIndex);
+  }
+
+  Status = EFI_SUCCESS;
+  DescNumber = 0;
+  for (Index = 0; Index < VTdUnitInfo->PendingInvalidationNumber; Index++) {
+    Pending = &VTdUnitInfo->PendingInvalidation[Index];
+
+    if (Granularity == VTD_INVALIDATION_GRANULARITY_DOMAIN) {
+      //
+      // Invalidate each domain only once.
+      //
+      for (Index2 = 0; Index2 < Index; Index2++) {
+        if (VTdUnitInfo->PendingInvalidation[Index2].DomainIdentifier == Pending->DomainIdentifier) {
+          break;
+        }
+      }
+      if (Index2 == Index) {
+        Status = AddIOTLBInvalidation (VtdIndex, Granularity, Pending->DomainIdentifier, 0, 0, QiDesc, &DescNumber);
+      }
+    } else {
+      Address = Pending->BaseAddress;
+      PageNumber = RShiftU64 (Pending->Length, VTD_PAGE_SHIFT);
+      while ((PageNumber != 0) && !EFI_ERROR (Status)) {
+        AddressMask = GetPageInvalidationAddressMask (VtdIndex, Address, PageNumber);
+        Status = AddIOTLBInvalidation (VtdIndex, Granularity, Pending->DomainIdentifier, Address, AddressMask, QiDesc, &DescNumber);
+        Address += LShiftU64 (SIZE_4KB, AddressMask);
+        PageNumber -= LShiftU64 (1, AddressMask);
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (DescNumber != 0) {
+    Status = SubmitQueuedInvalidationDescriptors (VtdIndex, QiDesc, DescNumber);
+  }
+
+  return Status;
+}
+
+/**
+  Dump the VTd IOTLB invalidation statistics.
+
+  @param[in]  VtdIndex              The index of VTd engine.
+**/
+VOID
+DumpVtdInvalidationStatistics (
+  IN UINTN  VtdIndex
+  )
+{
+  VTD_INVALIDATION_STATISTICS  *Statistics;
+
+  Statistics = &mVtdUnitInformation[VtdIndex].InvalidationStatistics;
+  DEBUG ((
+    DEBUG_INFO,
+    "VTd(%d) IOTLB invalidations - Global: %Lu, Domain: %Lu, Page: %Lu, Queued submissions: %Lu\n",
+    VtdIndex,
+    (UINT64)Statistics->GlobalInvalidations,
+    (UINT64)Statistics->DomainInvalidations,
+    (UINT64)Statistics->PageInvalidations,
+    (UINT64)Statistics->QueuedSubmissions
+    ));
+}
+
 /**
   Prepare VTD configuration.
 **/
@@ -944,6 +1311,8 @@ DumpVtdRegsAll (
   for (Num = 0; Num < mVtdUnitNumber; Num++) {
     DumpVtdRegs (Num);
   }
+
+  DEBUG ((DEBUG_INFO, "VTd translation table memory - 0x%Lx pages (%Lu KB)\n", (UINT64) mVtdTranslationTablePages, (UINT64) (EFI_PAGES_TO_SIZE (mVtdTranslationTablePages) / SIZE_1KB)));
 }
 
 /**
@@ -0,0 +1,50 @@
+/** @file
+  The definition of the SPI FVB statistics MMI.
+
+  The SpiFvbService MM driver registers an MMI handler with this GUID. A caller
+  sends a communicate buffer holding a SPI_FVB_STATISTICS structure and gets it
+  back filled with the driver's flash access counters.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _SPI_FVB_STATISTICS_H_
+#define _SPI_FVB_STATISTICS_H_
+
+#define SPI_FVB_STATISTICS_GUID \
+  { \
+    0x14fa23a5, 0x4fa0, 0x4a35, { 0xab, 0x94, 0x93, 0x1b, 0x72, 0xf5, 0x18, 0xc2 } \
+  }
+
+extern EFI_GUID gSpiFvbStatisticsGuid;
+
+typedef struct {
+  //
+  // Number of FVB Write() requests.
+  //
+  UINT64    WriteRequests;
+  //
+  // Number of bytes written through FVB Write().
+  //
+  UINT64    BytesWritten;
+  //
+  // Number of writes issued to the SPI flash. Lower than WriteRequests
+  // when write coalescing merged adjacent requests.
+  //
+  UINT64    FlashWriteCommands;
+  //
+  // Number of FVB Write() requests appended to a pending burst.
+  //
+  UINT64    CoalescedWrites;
+  //
+  // Number of blocks erased.
+  //
+  UINT64    BlockErases;
+  //
+  // Number of SPI flash lock requests.
+  //
+  UINT64    FlashLocks;
+} SPI_FVB_STATISTICS;
+
+#endif
@@ -230,7 +230,7 @@ MvSpiFlashRead (
     }
     SpiFlashFormatAddress (ReadAddr, Slave->AddrSize, Cmd);
     // Program proper read address and read data
-    Status = MvSpiFlashReadCmd (Slave, Cmd, Slave->AddrSize + 2, Buf, Length);
+    Status = MvSpiFlashReadCmd (Slave, Cmd, Slave->AddrSize + 2, Buf, ReadLength);
 
     Offset += ReadLength;
     Length -= ReadLength;
@@ -283,6 +283,64 @@ MvSpiFlashWrite (
   return EFI_SUCCESS;
 }
 
+/**
+  Program the pages of a flash range whose new contents differ from the
+  current ones, skipping the pages that would not change.
+
+  @param[in]  Slave      SPI flash device.
+  @param[in]  Offset     Flash offset of the range.
+  @param[in]  Length     Length of the range in bytes.
+  @param[in]  Buf        New contents of the range.
+  @param[in]  OldBuf     Current contents of the range, or NULL if it is
+                         erased (all 0xFF).
+
+  @retval EFI_SUCCESS    The range now holds Buf.
+  @retval Others         Programming failed.
+**/
+STATIC
+EFI_STATUS
+MvSpiFlashWriteChangedPages (
+  IN SPI_DEVICE *Slave,
+  IN UINT32 Offset,
+  IN UINTN Length,
+  IN UINT8 *Buf,
+  IN UINT8 *OldBuf OPTIONAL
+  )
+{
+  EFI_STATUS Status;
+  UINTN PageSize, ChunkLength, Index, ByteIndex;
+  BOOLEAN Changed;
+
+  PageSize = Slave->Info->PageSize;
+
+  for (Index = 0; Index < Length; Index += ChunkLength) {
+    ChunkLength = MIN (Length - Index, PageSize - ((Offset + Index) % PageSize));
+
+    if (OldBuf != NULL) {
+      Changed = CompareMem (&Buf[Index], &OldBuf[Index], ChunkLength) != 0;
+    } else {
+      Changed = FALSE;
+      for (ByteIndex = Index; ByteIndex < Index + ChunkLength; ByteIndex++) {
+        if (Buf[ByteIndex] != 0xFF) {
+          Changed = TRUE;
+          break;
+        }
+      }
+    }
+
+    if (!Changed) {
+      continue;
+    }
+
+    Status = MvSpiFlashWrite (Slave, (UINT32)(Offset + Index), ChunkLength, &Buf[Index]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 STATIC
 EFI_STATUS
 MvSpiFlashUpdateBlock (
@@ -291,10 +349,13 @@ MvSpiFlashUpdateBlock (
   IN UINTN ToUpdate,
   IN UINT8 *Buf,
   IN UINT8 *TmpBuf,
-  IN UINTN EraseSize
+  IN UINTN EraseSize,
+  IN OUT SPI_FLASH_UPDATE_STATS *Stats
   )
 {
   EFI_STATUS Status;
+  UINTN Index;
+  BOOLEAN NeedErase;
 
   // Read backup
   Status = MvSpiFlashRead (Slave, Offset, EraseSize, TmpBuf);
@@ -303,6 +364,35 @@ MvSpiFlashUpdateBlock (
       return Status;
     }
 
+  // Nothing to do if the sector already holds the new data
+  if (CompareMem (TmpBuf, Buf, ToUpdate) == 0) {
+    Stats->Skipped++;
+    return EFI_SUCCESS;
+  }
+
+  // Programming can only clear bits, an erase is needed to set any
+  NeedErase = FALSE;
+  for (Index = 0; Index < ToUpdate; Index++) {
+    if ((TmpBuf[Index] & Buf[Index]) != Buf[Index]) {
+      NeedErase = TRUE;
+      break;
+    }
+  }
+
+  if (!NeedErase) {
+    Status = MvSpiFlashWriteChangedPages (Slave, Offset, ToUpdate, Buf, TmpBuf);
+    if (EFI_ERROR (Status)) {
+      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
+      return Status;
+    }
+
+    Stats->Programmed++;
+    return EFI_SUCCESS;
+  }
+
+  // Merge the new data with the backup of the rest of the sector
+  CopyMem (TmpBuf, Buf, ToUpdate);
+
   // Erase entire sector
   Status = MvSpiFlashErase (Slave, Offset, EraseSize);
   if (EFI_ERROR (Status)) {
@@ -310,26 +400,47 @@ MvSpiFlashUpdateBlock (
       return Status;
     }
 
-  // Write new data
-  MvSpiFlashWrite (Slave, Offset, ToUpdate, Buf);
+  // Write new data and backup, leaving erased pages alone
+  Status = MvSpiFlashWriteChangedPages (Slave, Offset, EraseSize, TmpBuf, NULL);
   if (EFI_ERROR (Status)) {
       DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
       return Status;
     }
 
-  // Write backup
-  if (ToUpdate != EraseSize) {
-    Status = MvSpiFlashWrite (Slave, Offset + ToUpdate, EraseSize - ToUpdate,
-      &TmpBuf[ToUpdate]);
-    if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing backup\n"));
-      return Status;
-    }
-  }
-
+  Stats->Erased++;
   return EFI_SUCCESS;
 }
 
+/**
+  Report how an update went: how many sectors could be left alone or
+  programmed without an erase, and the effective throughput.
+
+  @param[in]  Stats          Per-sector results of the update.
+  @param[in]  ByteCount      Number of bytes updated.
+  @param[in]  StartTicks     Performance counter value at the start of the update.
+**/
+STATIC
+VOID
+MvSpiFlashReportUpdate (
+  IN SPI_FLASH_UPDATE_STATS *Stats,
+  IN UINTN                  ByteCount,
+  IN UINT64                 StartTicks
+  )
+{
+  UINT64 ElapsedMs;
+
+  ElapsedMs = GetTimeInNanoSecond (GetPerformanceCounter () - StartTicks) / 1000000;
+
+  DEBUG ((DEBUG_INFO,
+    "SpiFlash: Updated %Lu KB in %Lu ms (%Lu KB/s): %Lu sectors unchanged, %Lu programmed, %Lu erased\n",
+    (UINT64)(ByteCount / SIZE_1KB),
+    ElapsedMs,
+    ElapsedMs != 0 ? ((UINT64)ByteCount * 1000 / SIZE_1KB) / ElapsedMs : 0,
+    (UINT64)Stats->Skipped,
+    (UINT64)Stats->Programmed,
+    (UINT64)Stats->Erased));
+}
+
 EFI_STATUS
 MvSpiFlashUpdate (
   IN SPI_DEVICE *Slave,
@@ -341,6 +452,8 @@ MvSpiFlashUpdate (
   EFI_STATUS Status;
   UINT64 SectorSize, ToUpdate, Scale = 1;
   UINT8 *TmpBuf, *End;
+  SPI_FLASH_UPDATE_STATS Stats;
+  UINT64 StartTicks;
 
   SectorSize = Slave->Info->SectorSize;
 
@@ -352,16 +465,20 @@ MvSpiFlashUpdate (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  ZeroMem (&Stats, sizeof (Stats));
+  StartTicks = GetPerformanceCounter ();
+
   if (End - Buf >= 200)
     Scale = (End - Buf) / 100;
 
   for (; Buf < End; Buf += ToUpdate, Offset += ToUpdate) {
     ToUpdate = MIN((UINT64)(End - Buf), SectorSize);
     Print (L"   \rUpdating, %d%%", 100 - (End - Buf) / Scale);
-    Status = MvSpiFlashUpdateBlock (Slave, Offset, ToUpdate, Buf, TmpBuf, SectorSize);
+    Status = MvSpiFlashUpdateBlock (Slave, Offset, ToUpdate, Buf, TmpBuf, SectorSize, &Stats);
 
     if (EFI_ERROR (Status)) {
       DEBUG((DEBUG_ERROR, "SpiFlash: Error while updating\n"));
+      FreePool (TmpBuf);
       return Status;
     }
   }
@@ -369,6 +486,8 @@ MvSpiFlashUpdate (
   Print(L"\n");
   FreePool (TmpBuf);
 
+  MvSpiFlashReportUpdate (&Stats, ByteCount, StartTicks);
+
   return EFI_SUCCESS;
 }
 
@@ -389,6 +508,8 @@ MvSpiFlashUpdateWithProgress (
   UINTN ToUpdate;
   UINTN Index;
   UINT8 *TmpBuf;
+  SPI_FLASH_UPDATE_STATS Stats;
+  UINT64 StartTicks;
 
   SectorSize = Slave->Info->SectorSize;
   SectorNum = (ByteCount / SectorSize) + 1;
@@ -400,6 +521,9 @@ MvSpiFlashUpdateWithProgress (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  ZeroMem (&Stats, sizeof (Stats));
+  StartTicks = GetPerformanceCounter ();
+
   for (Index = 0; Index < SectorNum; Index++) {
     if (Progress != NULL) {
       Progress (StartPercentage +
@@ -409,6 +533,9 @@ MvSpiFlashUpdateWithProgress (
     // In the last chunk update only an actual number of remaining bytes.
     if (Index + 1 == SectorNum) {
       ToUpdate = ByteCount % SectorSize;
+      if (ToUpdate == 0) {
+        break;
+      }
     }
 
     Status = MvSpiFlashUpdateBlock (Slave,
@@ -416,14 +543,18 @@ MvSpiFlashUpdateWithProgress (
                ToUpdate,
                Buffer + Index * SectorSize,
                TmpBuf,
-               SectorSize);
+               SectorSize,
+               &Stats);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Error while updating\n", __FUNCTION__));
+      FreePool (TmpBuf);
       return Status;
     }
   }
   FreePool (TmpBuf);
 
+  MvSpiFlashReportUpdate (&Stats, ByteCount, StartTicks);
+
   if (Progress != NULL) {
     Progress (EndPercentage);
   }
@@ -12,6 +12,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
 #include <Uefi/UefiBaseType.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -56,6 +57,12 @@ typedef enum {
   SPI_COMMAND_MAX
 } SPI_COMMAND;
 
+typedef struct {
+  UINTN                   Skipped;        // Sectors that already held the new data
+  UINTN                   Programmed;     // Sectors written without an erase (1 -> 0 bit changes only)
+  UINTN                   Erased;         // Sectors erased and rewritten
+} SPI_FLASH_UPDATE_STATS;
+
 typedef struct {
   MARVELL_SPI_FLASH_PROTOCOL  SpiFlashProtocol;
   UINTN                   Signature;
@@ -39,6 +39,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Serial Memory Interface Configuration Register Masks
 #define SPI_BYTE_LENGTH_OFFSET          5
 #define SPI_BYTE_LENGTH                 (0x1  << SPI_BYTE_LENGTH_OFFSET)
+#define SPI_WIDE_WORD_SIZE              2     // Bytes per transfer in 16-bit mode
 #define SPI_CPOL_OFFSET                 11
 #define SPI_CPOL_MASK                   (0x1 << SPI_CPOL_OFFSET)
 #define SPI_CPHA_OFFSET                 12